@@ -0,0 +1,254 @@
+#include "bench.h"
+#include "parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+
+#ifndef MATHS_BENCH_BUILD_TYPE
+#define MATHS_BENCH_BUILD_TYPE ""
+#endif
+
+namespace {
+struct BenchEntry {
+  std::string name;
+  const char *kind;
+  unsigned int items;
+  BenchSetup setup;
+};
+
+struct BenchResult {
+  const BenchEntry *entry;
+  unsigned long long iterations;
+  double nsPerItem;
+  double nsPerItemMin;
+  double nsPerItemMax;
+};
+
+struct Options {
+  const char *filter = "";
+  const char *json = nullptr;
+  double minTime = 0.05;
+  unsigned int repetitions = 5;
+  unsigned int seed = 12345;
+  bool list = false;
+};
+
+std::vector<BenchEntry> &entries() {
+  static std::vector<BenchEntry> list;
+  return list;
+}
+
+std::mt19937 &rng() {
+  static std::mt19937 engine;
+  return engine;
+}
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+double timeBody(const BenchBody &body, unsigned long long iterations) {
+  Clock::time_point start = Clock::now();
+  for (unsigned long long i = 0; i < iterations; ++i) {
+    body();
+  }
+  return secondsSince(start);
+}
+
+BenchResult run(const BenchEntry &entry, const Options &options) {
+  rng().seed(options.seed);
+  BenchBody body = entry.setup();
+  body();
+
+  // Grow the iteration count until one sample takes about minTime
+  unsigned long long iterations = 1;
+  double elapsed = timeBody(body, iterations);
+  while (elapsed < options.minTime) {
+    double scale = elapsed > 0.0 ? options.minTime / elapsed * 1.2 : 10.0;
+    scale = std::min(std::max(scale, 2.0), 100.0);
+    iterations = (unsigned long long)(iterations * scale) + 1;
+    elapsed = timeBody(body, iterations);
+  }
+
+  std::vector<double> samples;
+  for (unsigned int r = 0; r < options.repetitions; ++r) {
+    samples.push_back(timeBody(body, iterations) * 1e9 /
+                      ((double)iterations * entry.items));
+  }
+  std::sort(samples.begin(), samples.end());
+  return {&entry, iterations, samples[samples.size() / 2], samples.front(),
+          samples.back()};
+}
+
+const char *simdName() {
+#if defined(__AVX2__)
+  return "avx2";
+#elif defined(__SSE2__) || defined(_M_X64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  return "sse2";
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+  return "neon";
+#else
+  return "scalar";
+#endif
+}
+
+const char *compilerName() {
+#if defined(__clang__)
+  return "clang " __clang_version__;
+#elif defined(__GNUC__)
+  return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+  return "msvc";
+#else
+  return "unknown";
+#endif
+}
+
+void writeJson(FILE *f, const std::vector<BenchResult> &results,
+               const Options &options) {
+  char date[32];
+  time_t now = time(nullptr);
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+#ifdef MATHS_HEADER_ONLY
+  const char *headerOnly = "true";
+#else
+  const char *headerOnly = "false";
+#endif
+
+  fprintf(f, "{\n  \"context\": {\n");
+  fprintf(f, "    \"date\": \"%s\",\n", date);
+  fprintf(f, "    \"compiler\": \"%s\",\n", compilerName());
+  fprintf(f, "    \"build_type\": \"%s\",\n", MATHS_BENCH_BUILD_TYPE);
+  fprintf(f, "    \"simd\": \"%s\",\n", simdName());
+  fprintf(f, "    \"header_only\": %s,\n", headerOnly);
+  fprintf(f, "    \"threads\": %u,\n", parallelThreadCount());
+  fprintf(f, "    \"seed\": %u,\n", options.seed);
+  fprintf(f, "    \"repetitions\": %u\n  },\n", options.repetitions);
+  fprintf(f, "  \"benchmarks\": [");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const BenchResult &r = results[i];
+    fprintf(f, "%s\n    {\"name\": \"%s\", \"kind\": \"%s\", \"items\": %u, ",
+            i ? "," : "", r.entry->name.c_str(), r.entry->kind,
+            r.entry->items);
+    fprintf(f, "\"iterations\": %llu, \"time_unit\": \"ns\", ", r.iterations);
+    fprintf(f, "\"ns_per_item\": %.4f, \"ns_per_item_min\": %.4f, ",
+            r.nsPerItem, r.nsPerItemMin);
+    fprintf(f, "\"ns_per_item_max\": %.4f, \"items_per_second\": %.1f}",
+            r.nsPerItemMax, 1e9 / r.nsPerItem);
+  }
+  fprintf(f, "\n  ]\n}\n");
+}
+
+bool parseOptions(int argc, char **argv, Options &options) {
+  for (int i = 1; i < argc; ++i) {
+    const char *a = argv[i];
+    if (strncmp(a, "--filter=", 9) == 0) {
+      options.filter = a + 9;
+    } else if (strncmp(a, "--json=", 7) == 0) {
+      options.json = a + 7;
+    } else if (strncmp(a, "--min-time=", 11) == 0) {
+      options.minTime = atof(a + 11);
+    } else if (strncmp(a, "--repetitions=", 14) == 0) {
+      options.repetitions = std::max(1, atoi(a + 14));
+    } else if (strncmp(a, "--seed=", 7) == 0) {
+      options.seed = (unsigned int)strtoul(a + 7, nullptr, 10);
+    } else if (strcmp(a, "--list") == 0) {
+      options.list = true;
+    } else {
+      fprintf(stderr,
+              "usage: %s [--filter=substring] [--json=file|-] "
+              "[--min-time=seconds] [--repetitions=n] [--seed=n] [--list]\n",
+              argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+void addBench(const std::string &name, const char *kind, unsigned int items,
+              const BenchSetup &setup) {
+  entries().push_back({name, kind, items, setup});
+}
+
+#if defined(__GNUC__)
+void benchEscape(const void *p) { asm volatile("" : : "g"(p) : "memory"); }
+#else
+static const void *volatile benchSink;
+void benchEscape(const void *p) { benchSink = p; }
+#endif
+
+float randomFloat(float lo, float hi) {
+  return std::uniform_real_distribution<float>(lo, hi)(rng());
+}
+
+vec3 randomVec3(float range) {
+  return vec3(randomFloat(-range, range), randomFloat(-range, range),
+              randomFloat(-range, range));
+}
+
+quat randomQuat() {
+  std::normal_distribution<float> n;
+  return normalized(quat(n(rng()), n(rng()), n(rng()), n(rng())));
+}
+
+Transform randomTransform(float minScale, float maxScale) {
+  return Transform(randomVec3(10.0f), randomQuat(),
+                   vec3(randomFloat(minScale, maxScale),
+                        randomFloat(minScale, maxScale),
+                        randomFloat(minScale, maxScale)));
+}
+
+mat4 randomMat4() { return transformToMat4(randomTransform(0.5f, 2.0f)); }
+
+DualQuaternion randomDualQuat() {
+  return transformToDualQuat(randomTransform(1.0f, 1.0f));
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    return 1;
+  }
+  registerOpBenches();
+  registerBatchBenches();
+
+  bool table = !options.json || strcmp(options.json, "-") != 0;
+  std::vector<BenchResult> results;
+  for (const BenchEntry &entry : entries()) {
+    if (!strstr(entry.name.c_str(), options.filter)) {
+      continue;
+    }
+    if (options.list) {
+      printf("%s\n", entry.name.c_str());
+      continue;
+    }
+    results.push_back(run(entry, options));
+    if (table) {
+      const BenchResult &r = results.back();
+      printf("%-48s %-10s %10.3f ns/item %14.0f items/s\n", entry.name.c_str(),
+             entry.kind, r.nsPerItem, 1e9 / r.nsPerItem);
+      fflush(stdout);
+    }
+  }
+
+  if (options.json && !options.list) {
+    FILE *f = table ? fopen(options.json, "w") : stdout;
+    if (!f) {
+      fprintf(stderr, "cannot open %s\n", options.json);
+      return 1;
+    }
+    writeJson(f, results, options);
+    if (f != stdout) {
+      fclose(f);
+    }
+  }
+  return 0;
+}
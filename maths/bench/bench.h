@@ -0,0 +1,44 @@
+#pragma once
+// Self-contained microbenchmark harness for maths_bench. A benchmark is a
+// setup function returning a body; the body performs `items` operations and
+// is timed in calibrated batches. Setup runs only for selected benchmarks,
+// right after the random generator is reseeded, so inputs do not depend on
+// which other benchmarks ran.
+#include "dualQuaternion.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+typedef std::function<void()> BenchBody;
+typedef std::function<BenchBody()> BenchSetup;
+
+// latency: each operation depends on the previous result.
+// throughput: independent operations over a hot input array.
+// batch: one call of a batch entry point over `items` elements.
+void addBench(const std::string &name, const char *kind, unsigned int items,
+              const BenchSetup &setup);
+
+void registerOpBenches();
+void registerBatchBenches();
+
+// Keeps the compiler from discarding a result.
+void benchEscape(const void *p);
+template <typename T> inline void benchKeep(const T &v) { benchEscape(&v); }
+
+float randomFloat(float lo, float hi);
+vec3 randomVec3(float range);
+quat randomQuat();
+// Scale is uniform per axis in [minScale, maxScale].
+Transform randomTransform(float minScale, float maxScale);
+mat4 randomMat4();
+DualQuaternion randomDualQuat();
+
+template <typename T, typename F>
+std::vector<T> randomArray(unsigned int count, const F &generate) {
+  std::vector<T> out;
+  out.reserve(count);
+  for (unsigned int i = 0; i < count; ++i) {
+    out.push_back(generate());
+  }
+  return out;
+}
@@ -0,0 +1,530 @@
+#include "animation.h"
+#include "binaryFile.h"
+#include "bench.h"
+#include "bounds.h"
+#include "bvh.h"
+#include "hierarchy.h"
+#include "integration.h"
+#include "quantize.h"
+#include "ray.h"
+#include "sceneTransforms.h"
+#include "skinning.h"
+#include "textFormat.h"
+#include <memory>
+
+// Batch entry points swept over element counts from cache resident to
+// memory bound.
+static const unsigned int kSizes[] = {16, 256, 4096, 65536};
+
+namespace {
+// setup(unsigned int n) returns the body for one batch size
+template <typename S>
+void sweep(const std::string &name, const S &setup) {
+  for (unsigned int n : kSizes) {
+    addBench(name + "/" + std::to_string(n), "batch", n,
+             [setup, n]() -> BenchBody { return setup(n); });
+  }
+}
+
+template <typename T, typename F>
+std::shared_ptr<std::vector<T>> shared(unsigned int n, const F &generate) {
+  return std::make_shared<std::vector<T>>(randomArray<T>(n, generate));
+}
+
+std::shared_ptr<std::vector<vec3>> points(unsigned int n) {
+  return shared<vec3>(n, [] { return randomVec3(10.0f); });
+}
+
+void registerMat4() {
+  sweep("mat4/transformPoints.aos", [](unsigned int n) -> BenchBody {
+    mat4 m = randomMat4();
+    auto in = points(n);
+    auto out = std::make_shared<std::vector<vec3>>(n);
+    return [=]() { transformPoints(m, in->data(), out->data(), n); };
+  });
+  sweep("mat4/transformPoints.parallel", [](unsigned int n) -> BenchBody {
+    mat4 m = randomMat4();
+    auto in = points(n);
+    auto out = std::make_shared<std::vector<vec3>>(n);
+    return [=]() { transformPointsParallel(m, in->data(), out->data(), n); };
+  });
+  sweep("mat4/transformPoints.soa", [](unsigned int n) -> BenchBody {
+    mat4 m = randomMat4();
+    auto in = shared<float>(n * 3, [] { return randomFloat(-10, 10); });
+    auto out = std::make_shared<std::vector<float>>(n * 3);
+    return [=]() {
+      float *i = in->data();
+      float *o = out->data();
+      transformPoints(m, Vec3SoA{i, i + n, i + 2 * n},
+                      Vec3SoA{o, o + n, o + 2 * n}, n);
+    };
+  });
+  sweep("mat4/inverse", [](unsigned int n) -> BenchBody {
+    auto in = shared<mat4>(n, randomMat4);
+    auto out = std::make_shared<std::vector<mat4>>(n);
+    return [=]() { benchKeep(inverse(in->data(), out->data(), n)); };
+  });
+  sweep("mat4/inverseAffine", [](unsigned int n) -> BenchBody {
+    auto in = shared<mat4>(n, randomMat4);
+    auto out = std::make_shared<std::vector<mat4>>(n);
+    return [=]() { benchKeep(inverseAffine(in->data(), out->data(), n)); };
+  });
+  sweep("mat4/inverseRigid", [](unsigned int n) -> BenchBody {
+    auto in = shared<mat4>(
+        n, [] { return transformToMat4(randomTransform(1.0f, 1.0f)); });
+    auto out = std::make_shared<std::vector<mat4>>(n);
+    return [=]() { inverseRigid(in->data(), out->data(), n); };
+  });
+}
+
+void registerBounds() {
+  sweep("bounds/computeAabb", [](unsigned int n) -> BenchBody {
+    auto in = points(n);
+    return [=]() { benchKeep(computeAabb(in->data(), n)); };
+  });
+  sweep("bounds/computeAabb.transformed", [](unsigned int n) -> BenchBody {
+    mat4 m = randomMat4();
+    auto in = points(n);
+    return [=]() { benchKeep(computeAabb(m, in->data(), n)); };
+  });
+  sweep("bounds/computeSphere.transformed", [](unsigned int n) -> BenchBody {
+    mat4 m = randomMat4();
+    auto in = points(n);
+    return [=]() { benchKeep(computeSphere(m, in->data(), n)); };
+  });
+  sweep("bounds/transformAabbs", [](unsigned int n) -> BenchBody {
+    auto m = shared<mat4>(n, randomMat4);
+    auto in = shared<Aabb>(n, [] {
+      vec3 a = randomVec3(10.0f);
+      return Aabb{a, a + vec3(1.0f, 2.0f, 3.0f)};
+    });
+    auto out = std::make_shared<std::vector<Aabb>>(n);
+    return [=]() { transformAabbs(m->data(), in->data(), out->data(), n); };
+  });
+}
+
+// Triangles scattered around the origin, and rays from outside aimed at it
+std::shared_ptr<std::vector<vec3>> triangles(unsigned int n) {
+  auto v = std::make_shared<std::vector<vec3>>(n * 3);
+  for (unsigned int i = 0; i < n; ++i) {
+    vec3 c = randomVec3(10.0f);
+    for (int k = 0; k < 3; ++k) {
+      (*v)[i * 3 + k] = c + randomVec3(1.0f);
+    }
+  }
+  return v;
+}
+
+Ray randomRay() {
+  vec3 origin = randomVec3(20.0f);
+  return {origin, randomVec3(2.0f) - origin};
+}
+
+void registerRay() {
+  sweep("ray/intersectTriangles", [](unsigned int n) -> BenchBody {
+    auto v = triangles(n);
+    Ray ray = randomRay();
+    return [=]() {
+      benchKeep(intersectTriangles(ray, v->data(), nullptr, n, 1e30f));
+    };
+  });
+  sweep("ray/intersectTriangles.packet8", [](unsigned int n) -> BenchBody {
+    auto v = triangles(n);
+    Ray rays[8];
+    for (Ray &r : rays) {
+      r = randomRay();
+    }
+    RayPacket8 packet = makeRayPacket8(rays);
+    return [=]() {
+      RayHits8 hits;
+      makeRayHits(1e30f, hits);
+      intersectTriangles(packet, v->data(), nullptr, n, hits);
+      benchKeep(hits);
+    };
+  });
+  sweep("ray/intersectAabbs", [](unsigned int n) -> BenchBody {
+    auto boxes = shared<Aabb>(n, [] {
+      vec3 a = randomVec3(10.0f);
+      return Aabb{a, a + vec3(1.0f, 1.0f, 1.0f)};
+    });
+    Ray ray = randomRay();
+    return [=]() {
+      benchKeep(intersectAabbs(ray, boxes->data(), n, 1e30f));
+    };
+  });
+}
+
+void registerBvh() {
+  sweep("bvh/build", [](unsigned int n) -> BenchBody {
+    auto v = triangles(n);
+    auto bvh = std::make_shared<Bvh>();
+    return [=]() { buildBvh(*bvh, v->data(), nullptr, n); };
+  });
+  sweep("bvh/refit", [](unsigned int n) -> BenchBody {
+    auto v = triangles(n);
+    auto bvh = std::make_shared<Bvh>();
+    buildBvh(*bvh, v->data(), nullptr, n);
+    return [=]() { refitBvh(*bvh, v->data(), nullptr); };
+  });
+  sweep("bvh/intersect", [](unsigned int n) -> BenchBody {
+    auto v = triangles(n);
+    auto bvh = std::make_shared<Bvh>();
+    buildBvh(*bvh, v->data(), nullptr, n);
+    Ray ray = randomRay();
+    return [=]() {
+      benchKeep(intersectBvh(*bvh, ray, v->data(), nullptr, 1e30f));
+    };
+  });
+}
+
+void registerQuat() {
+  sweep("quat/fastSlerp", [](unsigned int n) -> BenchBody {
+    auto a = shared<quat>(n, randomQuat);
+    auto b = shared<quat>(n, randomQuat);
+    auto out = std::make_shared<std::vector<quat>>(n);
+    return [=]() { fastSlerp(a->data(), b->data(), 0.3f, out->data(), n); };
+  });
+  sweep("quat/fastSlerp.perElementT", [](unsigned int n) -> BenchBody {
+    auto a = shared<quat>(n, randomQuat);
+    auto b = shared<quat>(n, randomQuat);
+    auto t = shared<float>(n, [] { return randomFloat(0.0f, 1.0f); });
+    auto out = std::make_shared<std::vector<quat>>(n);
+    return [=]() {
+      fastSlerp(a->data(), b->data(), t->data(), out->data(), n);
+    };
+  });
+  sweep("quat/quatToMat4", [](unsigned int n) -> BenchBody {
+    auto in = shared<quat>(n, randomQuat);
+    auto out = std::make_shared<std::vector<mat4>>(n);
+    return [=]() { quatToMat4(in->data(), out->data(), n); };
+  });
+  sweep("quat/mat4ToQuat", [](unsigned int n) -> BenchBody {
+    auto in = shared<mat4>(n, randomMat4);
+    auto out = std::make_shared<std::vector<quat>>(n);
+    return [=]() { mat4ToQuat(in->data(), out->data(), n); };
+  });
+}
+
+void registerTransform() {
+  sweep("transform/transformToMat4", [](unsigned int n) -> BenchBody {
+    auto in = shared<Transform>(n, [] { return randomTransform(0.5f, 2.0f); });
+    auto out = std::make_shared<std::vector<mat4>>(n);
+    return [=]() { transformToMat4(in->data(), out->data(), n); };
+  });
+  sweep("transform/transformToMat4Parallel", [](unsigned int n) -> BenchBody {
+    auto in = shared<Transform>(n, [] { return randomTransform(0.5f, 2.0f); });
+    auto out = std::make_shared<std::vector<mat4>>(n);
+    return [=]() { transformToMat4Parallel(in->data(), out->data(), n); };
+  });
+  sweep("transform/toTransform", [](unsigned int n) -> BenchBody {
+    auto in = shared<mat4>(n, randomMat4);
+    auto out = std::make_shared<std::vector<Transform>>(n);
+    return [=]() { toTransform(in->data(), out->data(), n); };
+  });
+  sweep("transform/inverse", [](unsigned int n) -> BenchBody {
+    auto in = shared<Transform>(n, [] { return randomTransform(0.5f, 2.0f); });
+    auto out = std::make_shared<std::vector<Transform>>(n);
+    return [=]() { inverse(in->data(), out->data(), n); };
+  });
+}
+
+void registerBinary() {
+  sweep("binary/readSection.lz", [](unsigned int n) -> BenchBody {
+    auto t = shared<Transform>(
+        n, [] { return randomTransform(1.0f, 1.0f); });
+    BinarySectionDesc desc = {1, BinaryType::Transform, BinaryCompression::Lz,
+                              t->data(), n};
+    auto image = std::make_shared<std::vector<unsigned char>>();
+    writeBinaryFile(&desc, 1, *image);
+    auto out = std::make_shared<std::vector<Transform>>(n);
+    return [=]() {
+      BinaryFile file;
+      openBinaryFile(image->data(), image->size(), file);
+      benchKeep(readSection(file, 1, out->data(), n));
+    };
+  });
+}
+
+void registerText() {
+  sweep("text/formatTransform", [](unsigned int n) -> BenchBody {
+    auto in = shared<Transform>(n, [] { return randomTransform(1.0f, 1.0f); });
+    auto out = std::make_shared<std::vector<char>>(
+        (size_t)n * 10 * TEXT_FLOAT_MAX_CHARS);
+    return [=]() {
+      benchKeep(formatText(in->data(), out->data(), out->size(), n));
+    };
+  });
+  sweep("text/parseTransform", [](unsigned int n) -> BenchBody {
+    auto in = shared<Transform>(n, [] { return randomTransform(1.0f, 1.0f); });
+    auto text = std::make_shared<std::vector<char>>(
+        (size_t)n * 10 * TEXT_FLOAT_MAX_CHARS);
+    text->resize(formatText(in->data(), text->data(), text->size(), n));
+    auto out = std::make_shared<std::vector<Transform>>(n);
+    return [=]() {
+      benchKeep(parseText(text->data(), text->size(), out->data(), n));
+    };
+  });
+}
+
+void registerIntegration() {
+  sweep("integration/orientations", [](unsigned int n) -> BenchBody {
+    auto q = shared<quat>(n, randomQuat);
+    auto w = points(n);
+    return [=]() { integrateOrientations(q->data(), w->data(), 0.016f, n); };
+  });
+  sweep("integration/orientationsExp", [](unsigned int n) -> BenchBody {
+    auto q = shared<quat>(n, randomQuat);
+    auto w = points(n);
+    return [=]() {
+      integrateOrientationsExp(q->data(), w->data(), 0.016f, n);
+    };
+  });
+  sweep("integration/positions", [](unsigned int n) -> BenchBody {
+    auto p = points(n);
+    auto v = points(n);
+    return [=]() { integratePositions(p->data(), v->data(), 0.016f, n); };
+  });
+}
+
+void registerDualQuat() {
+  sweep("dualQuat/fromTransform", [](unsigned int n) -> BenchBody {
+    auto in = shared<Transform>(n, [] { return randomTransform(1.0f, 1.0f); });
+    auto out = std::make_shared<std::vector<DualQuaternion>>(n);
+    return [=]() { transformToDualQuat(in->data(), out->data(), n); };
+  });
+  sweep("dualQuat/transformPoints.cached", [](unsigned int n) -> BenchBody {
+    CachedDualQuaternion dq = cacheDualQuat(randomDualQuat());
+    auto in = points(n);
+    auto out = std::make_shared<std::vector<vec3>>(n);
+    return [=]() { transformPoints(dq, in->data(), out->data(), n); };
+  });
+  sweep("dualQuat/nlerp", [](unsigned int n) -> BenchBody {
+    auto a = shared<DualQuaternion>(n, randomDualQuat);
+    auto b = shared<DualQuaternion>(n, randomDualQuat);
+    auto out = std::make_shared<std::vector<DualQuaternion>>(n);
+    return [=]() { nlerp(a->data(), b->data(), 0.3f, out->data(), n); };
+  });
+}
+
+void registerQuantize() {
+  sweep("quantize/packTransform", [](unsigned int n) -> BenchBody {
+    auto in = shared<Transform>(n, [] { return randomTransform(1.0f, 1.0f); });
+    PositionRange range = positionRange(in->data(), n);
+    auto out = std::make_shared<std::vector<PackedTransform>>(n);
+    return [=]() { packTransform(in->data(), range, out->data(), n); };
+  });
+  sweep("quantize/unpackTransform", [](unsigned int n) -> BenchBody {
+    auto in = shared<Transform>(n, [] { return randomTransform(1.0f, 1.0f); });
+    PositionRange range = positionRange(in->data(), n);
+    auto packed = std::make_shared<std::vector<PackedTransform>>(n);
+    packTransform(in->data(), range, packed->data(), n);
+    auto out = std::make_shared<std::vector<Transform>>(n);
+    return [=]() { unpackTransform(packed->data(), range, out->data(), n); };
+  });
+  sweep("quantize/unpackQuat32", [](unsigned int n) -> BenchBody {
+    auto in = shared<quat>(n, randomQuat);
+    auto packed = std::make_shared<std::vector<PackedQuat32>>(n);
+    packQuat32(in->data(), packed->data(), n);
+    auto out = std::make_shared<std::vector<quat>>(n);
+    return [=]() { unpackQuat32(packed->data(), out->data(), n); };
+  });
+}
+
+struct SkinInputs {
+  std::vector<DualQuaternion> palette;
+  std::vector<ivec4> joints;
+  std::vector<vec4> weights;
+  std::vector<vec3> positions;
+  std::vector<vec3> normals;
+  std::vector<vec3> outPositions;
+  std::vector<vec3> outNormals;
+
+  SkinInputs(unsigned int n)
+      : palette(randomArray<DualQuaternion>(64, randomDualQuat)),
+        positions(randomArray<vec3>(n, [] { return randomVec3(1.0f); })),
+        normals(randomArray<vec3>(
+            n, [] { return normalized(randomVec3(1.0f)); })),
+        outPositions(n), outNormals(n) {
+    for (unsigned int i = 0; i < n; ++i) {
+      float w[4];
+      float sum = 0.0f;
+      for (int j = 0; j < 4; ++j) {
+        w[j] = randomFloat(0.0f, 1.0f);
+        sum += w[j];
+      }
+      joints.push_back(ivec4(i % 64, (i + 7) % 64, (i + 19) % 64, i / 7 % 64));
+      weights.push_back(vec4(w[0] / sum, w[1] / sum, w[2] / sum, w[3] / sum));
+    }
+  }
+};
+
+// n playing instances of one 32 joint clip, each at its own time
+struct ClipInputs {
+  AnimationClip clip;
+  std::vector<Transform> poses;
+  std::vector<unsigned int> cursors;
+  std::vector<ClipSample> samples;
+
+  ClipInputs(unsigned int n)
+      : clip(32), poses(n * 32), cursors(n * 32 * 3, 0u), samples(n) {
+    const unsigned int keys = 30;
+    std::vector<float> times(keys);
+    for (unsigned int k = 0; k < keys; ++k) {
+      times[k] = k / 30.0f;
+    }
+    for (unsigned int j = 0; j < 32; ++j) {
+      std::vector<float> p, r;
+      for (unsigned int k = 0; k < keys; ++k) {
+        vec3 v = randomVec3(1.0f);
+        quat q = randomQuat();
+        p.insert(p.end(), v.v, v.v + 3);
+        r.insert(r.end(), q.v, q.v + 4);
+      }
+      addTrack(clip, j, TrackTarget::Position, Interpolation::Linear,
+               times.data(), p.data(), keys);
+      addTrack(clip, j, TrackTarget::Rotation, Interpolation::Linear,
+               times.data(), r.data(), keys);
+    }
+    for (unsigned int i = 0; i < n; ++i) {
+      samples[i] = {&clip, randomFloat(0.0f, 1.0f), &cursors[i * 32 * 3],
+                    &poses[i * 32]};
+    }
+  }
+};
+
+// Four masked clips blended under two additive layers, n joints each
+struct BlendInputs {
+  std::vector<std::vector<Transform>> poses;
+  std::vector<float> mask;
+  std::vector<PoseLayer> layers;
+  std::vector<Transform> out;
+
+  BlendInputs(unsigned int n)
+      : poses(6), mask(randomArray<float>(
+                      n, [] { return randomFloat(0.0f, 1.0f); })),
+        out(n) {
+    for (unsigned int l = 0; l < 6; ++l) {
+      poses[l] = randomArray<Transform>(
+          n, [] { return randomTransform(0.9f, 1.1f); });
+      layers.push_back({poses[l].data(), randomFloat(0.2f, 1.0f),
+                        l % 2 ? mask.data() : nullptr, l >= 4});
+    }
+  }
+};
+
+// Joint i hangs off a random earlier joint
+std::vector<int> randomParents(unsigned int n) {
+  std::vector<int> parents(n);
+  for (unsigned int i = 0; i < n; ++i) {
+    parents[i] = i == 0 ? -1 : (int)randomFloat(0.0f, (float)i - 0.5f);
+  }
+  return parents;
+}
+
+void registerAnimation() {
+  sweep("skinning/dualQuaternion", [](unsigned int n) -> BenchBody {
+    auto s = std::make_shared<SkinInputs>(n);
+    return [=]() {
+      skinDualQuaternion(s->palette.data(), s->joints.data(),
+                         s->weights.data(), s->positions.data(),
+                         s->normals.data(), s->outPositions.data(),
+                         s->outNormals.data(), n);
+    };
+  });
+  sweep("skinning/dualQuaternionParallel", [](unsigned int n) -> BenchBody {
+    auto s = std::make_shared<SkinInputs>(n);
+    return [=]() {
+      skinDualQuaternionParallel(s->palette.data(), s->joints.data(),
+                                 s->weights.data(), s->positions.data(),
+                                 s->normals.data(), s->outPositions.data(),
+                                 s->outNormals.data(), n);
+    };
+  });
+  sweep("skinning/palette3x4", [](unsigned int n) -> BenchBody {
+    auto world = shared<Transform>(
+        n, [] { return randomTransform(0.9f, 1.1f); });
+    auto bind = shared<mat4>(
+        n, [] { return transformToMat4(randomTransform(0.9f, 1.1f)); });
+    auto out = std::make_shared<std::vector<float>>(n * 12);
+    return [=]() {
+      buildSkinningPalette(world->data(), bind->data(), out->data(), n);
+    };
+  });
+  sweep("skinning/paletteDualQuat", [](unsigned int n) -> BenchBody {
+    auto world = shared<Transform>(
+        n, [] { return randomTransform(1.0f, 1.0f); });
+    auto bind = shared<Transform>(
+        n, [] { return randomTransform(1.0f, 1.0f); });
+    auto out = std::make_shared<std::vector<DualQuaternion>>(n);
+    return [=]() {
+      buildSkinningPalette(world->data(), bind->data(), out->data(), n);
+    };
+  });
+  sweep("hierarchy/worldTransforms", [](unsigned int n) -> BenchBody {
+    auto local = shared<Transform>(
+        n, [] { return randomTransform(0.95f, 1.05f); });
+    auto parents = std::make_shared<std::vector<int>>(randomParents(n));
+    auto world = std::make_shared<std::vector<Transform>>(n);
+    return [=]() {
+      computeWorldTransforms(local->data(), parents->data(), world->data(), n);
+    };
+  });
+  sweep("hierarchy/worldMatrices", [](unsigned int n) -> BenchBody {
+    auto local = shared<Transform>(
+        n, [] { return randomTransform(0.95f, 1.05f); });
+    auto parents = std::make_shared<std::vector<int>>(randomParents(n));
+    auto world = std::make_shared<std::vector<mat4>>(n);
+    return [=]() {
+      computeWorldMatrices(local->data(), parents->data(), world->data(), n);
+    };
+  });
+  sweep("hierarchy/sceneUpdate.5percent", [](unsigned int n) -> BenchBody {
+    auto local = shared<Transform>(
+        n, [] { return randomTransform(0.95f, 1.05f); });
+    std::vector<int> parents = randomParents(n);
+    auto scene = std::make_shared<SceneTransforms>();
+    initSceneTransforms(*scene, local->data(), parents.data(), n);
+    updateSceneTransforms(*scene);
+    return [=]() {
+      // Every twentieth node from the back moves, mostly leaves and small
+      // subtrees like the props of a level
+      for (unsigned int i = 20; i <= n; i += 20) {
+        setLocalTransform(*scene, n - i, (*local)[n - i]);
+      }
+      updateSceneTransforms(*scene);
+    };
+  });
+  sweep("animation/blendPoses", [](unsigned int n) -> BenchBody {
+    auto b = std::make_shared<BlendInputs>(n);
+    return [=]() {
+      blendPoses(b->layers.data(), (unsigned int)b->layers.size(),
+                 b->out.data(), n);
+    };
+  });
+  sweep("animation/sampleClips", [](unsigned int n) -> BenchBody {
+    auto c = std::make_shared<ClipInputs>(n);
+    return [=]() {
+      // Advance by a frame each call, like sequential playback
+      for (ClipSample &s : c->samples) {
+        s.time += 1.0f / 60.0f;
+      }
+      sampleClips(c->samples.data(), n);
+    };
+  });
+}
+} // namespace
+
+void registerBatchBenches() {
+  registerMat4();
+  registerBounds();
+  registerRay();
+  registerBvh();
+  registerQuat();
+  registerTransform();
+  registerDualQuat();
+  registerBinary();
+  registerText();
+  registerIntegration();
+  registerQuantize();
+  registerAnimation();
+}
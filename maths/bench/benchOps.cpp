@@ -0,0 +1,242 @@
+#include "bench.h"
+#include <memory>
+
+// Per-operation benchmarks. Throughput runs over kOps independent inputs that
+// stay in cache; latency chains kOps calls through the previous result.
+static const unsigned int kOps = 1024;
+
+namespace {
+struct OpInputs {
+  std::vector<vec3> points;
+  std::vector<quat> rotations;
+  std::vector<quat> rotationsB;
+  std::vector<float> t;
+  std::vector<mat4> matrices;
+  std::vector<mat4> matricesB;
+  std::vector<mat4> rigid;
+  std::vector<Transform> transforms;
+  std::vector<Transform> transformsB;
+  std::vector<DualQuaternion> dualQuats;
+  std::vector<DualQuaternion> dualQuatsB;
+
+  OpInputs() {
+    points = randomArray<vec3>(kOps, [] { return randomVec3(10.0f); });
+    rotations = randomArray<quat>(kOps, randomQuat);
+    rotationsB = randomArray<quat>(kOps, randomQuat);
+    t = randomArray<float>(kOps, [] { return randomFloat(0.0f, 1.0f); });
+    matrices = randomArray<mat4>(kOps, randomMat4);
+    matricesB = randomArray<mat4>(kOps, randomMat4);
+    rigid = randomArray<mat4>(
+        kOps, [] { return transformToMat4(randomTransform(1.0f, 1.0f)); });
+    // Scales close to one keep long combine() chains finite
+    transforms = randomArray<Transform>(
+        kOps, [] { return randomTransform(0.95f, 1.05f); });
+    transformsB = randomArray<Transform>(
+        kOps, [] { return randomTransform(0.95f, 1.05f); });
+    dualQuats = randomArray<DualQuaternion>(kOps, randomDualQuat);
+    dualQuatsB = randomArray<DualQuaternion>(kOps, randomDualQuat);
+  }
+};
+
+// op(const OpInputs &, unsigned int i) returns the i-th independent result
+template <typename T, typename F>
+void throughput(const std::string &name, const F &op) {
+  addBench(name + "/throughput", "throughput", kOps, [op]() -> BenchBody {
+    std::shared_ptr<OpInputs> in = std::make_shared<OpInputs>();
+    std::shared_ptr<std::vector<T>> out =
+        std::make_shared<std::vector<T>>(kOps);
+    return [in, out, op]() {
+      T *o = out->data();
+      for (unsigned int i = 0; i < kOps; ++i) {
+        o[i] = op(*in, i);
+      }
+      benchKeep(o[0]);
+    };
+  });
+}
+
+// init(const OpInputs &) seeds the chain, step(const OpInputs &, x, i)
+// produces the next value from the previous one.
+template <typename T, typename I, typename F>
+void latency(const std::string &name, const I &init, const F &step) {
+  addBench(name + "/latency", "latency", kOps, [init, step]() -> BenchBody {
+    std::shared_ptr<OpInputs> in = std::make_shared<OpInputs>();
+    return [in, init, step]() {
+      T x = init(*in);
+      for (unsigned int i = 0; i < kOps; ++i) {
+        x = step(*in, x, i);
+      }
+      benchKeep(x);
+    };
+  });
+}
+
+typedef const OpInputs &In;
+
+void registerVec3() {
+  throughput<vec3>("vec3/cross", [](In in, unsigned int i) {
+    return cross(in.points[i], in.points[kOps - 1 - i]);
+  });
+  throughput<float>("vec3/dot", [](In in, unsigned int i) {
+    return dot(in.points[i], in.points[kOps - 1 - i]);
+  });
+  throughput<vec3>("vec3/normalized", [](In in, unsigned int i) {
+    return normalized(in.points[i]);
+  });
+  latency<vec3>(
+      "vec3/normalized", [](In in) { return in.points[0]; },
+      [](In in, const vec3 &v, unsigned int i) {
+        return normalized(v + in.points[i]);
+      });
+}
+
+void registerQuat() {
+  throughput<quat>("quat/mul", [](In in, unsigned int i) {
+    return in.rotations[i] * in.rotationsB[i];
+  });
+  latency<quat>(
+      "quat/mul", [](In) { return quat(); },
+      [](In in, const quat &q, unsigned int i) {
+        return q * in.rotations[i];
+      });
+  throughput<vec3>("quat/rotateVec3", [](In in, unsigned int i) {
+    return in.rotations[i] * in.points[i];
+  });
+  latency<vec3>(
+      "quat/rotateVec3", [](In in) { return in.points[0]; },
+      [](In in, const vec3 &v, unsigned int i) {
+        return in.rotations[i] * v;
+      });
+  throughput<quat>("quat/nlerp", [](In in, unsigned int i) {
+    return nlerp(in.rotations[i], in.rotationsB[i], in.t[i]);
+  });
+  throughput<quat>("quat/slerp", [](In in, unsigned int i) {
+    return slerp(in.rotations[i], in.rotationsB[i], in.t[i]);
+  });
+  latency<quat>(
+      "quat/slerp", [](In in) { return in.rotations[0]; },
+      [](In in, const quat &q, unsigned int i) {
+        return slerp(q, in.rotations[i], 0.5f);
+      });
+  throughput<quat>("quat/fastSlerp", [](In in, unsigned int i) {
+    return fastSlerp(in.rotations[i], in.rotationsB[i], in.t[i]);
+  });
+  latency<quat>(
+      "quat/fastSlerp", [](In in) { return in.rotations[0]; },
+      [](In in, const quat &q, unsigned int i) {
+        return fastSlerp(q, in.rotations[i], 0.5f);
+      });
+  throughput<mat4>("quat/quatToMat4", [](In in, unsigned int i) {
+    return quatToMat4(in.rotations[i]);
+  });
+  throughput<quat>("quat/mat4ToQuat", [](In in, unsigned int i) {
+    return mat4ToQuat(in.matrices[i]);
+  });
+}
+
+void registerMat4() {
+  throughput<mat4>("mat4/mul", [](In in, unsigned int i) {
+    return in.matrices[i] * in.matricesB[i];
+  });
+  latency<mat4>(
+      "mat4/mul", [](In) { return mat4(); },
+      [](In in, const mat4 &m, unsigned int i) { return m * in.rigid[i]; });
+  throughput<mat4>("mat4/transposed", [](In in, unsigned int i) {
+    return transposed(in.matrices[i]);
+  });
+  throughput<mat4>("mat4/inverse", [](In in, unsigned int i) {
+    return inverse(in.matrices[i]);
+  });
+  latency<mat4>(
+      "mat4/inverse", [](In in) { return in.matrices[0]; },
+      [](In, const mat4 &m, unsigned int) { return inverse(m); });
+  throughput<mat4>("mat4/inverseAffine", [](In in, unsigned int i) {
+    return inverseAffine(in.matrices[i]);
+  });
+  throughput<mat4>("mat4/inverseRigid", [](In in, unsigned int i) {
+    return inverseRigid(in.rigid[i]);
+  });
+  throughput<mat4>("mat4/inverseAuto", [](In in, unsigned int i) {
+    return inverseAuto(in.matrices[i]);
+  });
+  throughput<vec3>("mat4/transformPoint", [](In in, unsigned int i) {
+    return transformPoint(in.matrices[i], in.points[i]);
+  });
+  latency<vec3>(
+      "mat4/transformPoint", [](In in) { return in.points[0]; },
+      [](In in, const vec3 &p, unsigned int i) {
+        return transformPoint(in.rigid[i], p);
+      });
+}
+
+void registerTransform() {
+  throughput<Transform>("transform/combine", [](In in, unsigned int i) {
+    return combine(in.transforms[i], in.transformsB[i]);
+  });
+  latency<Transform>(
+      "transform/combine", [](In) { return Transform(); },
+      [](In in, const Transform &t, unsigned int i) {
+        return combine(t, in.transforms[i]);
+      });
+  throughput<Transform>("transform/inverse", [](In in, unsigned int i) {
+    return inverse(in.transforms[i]);
+  });
+  throughput<Transform>("transform/mix", [](In in, unsigned int i) {
+    return mix(in.transforms[i], in.transformsB[i], in.t[i]);
+  });
+  throughput<mat4>("transform/transformToMat4", [](In in, unsigned int i) {
+    return transformToMat4(in.transforms[i]);
+  });
+  throughput<Transform>("transform/toTransform", [](In in, unsigned int i) {
+    return toTransform(in.matrices[i]);
+  });
+  throughput<vec3>("transform/transformPoint", [](In in, unsigned int i) {
+    return transformPoint(in.transforms[i], in.points[i]);
+  });
+}
+
+void registerDualQuat() {
+  throughput<DualQuaternion>("dualQuat/mul", [](In in, unsigned int i) {
+    return in.dualQuats[i] * in.dualQuatsB[i];
+  });
+  latency<DualQuaternion>(
+      "dualQuat/mul", [](In) { return DualQuaternion(); },
+      [](In in, const DualQuaternion &d, unsigned int i) {
+        return d * in.dualQuats[i];
+      });
+  throughput<DualQuaternion>("dualQuat/mulUnchecked",
+                             [](In in, unsigned int i) {
+                               return mulUnchecked(in.dualQuats[i],
+                                                   in.dualQuatsB[i]);
+                             });
+  latency<DualQuaternion>(
+      "dualQuat/mulUnchecked", [](In) { return DualQuaternion(); },
+      [](In in, const DualQuaternion &d, unsigned int i) {
+        return mulUnchecked(d, in.dualQuats[i]);
+      });
+  throughput<DualQuaternion>("dualQuat/fromTransform",
+                             [](In in, unsigned int i) {
+                               return transformToDualQuat(in.transforms[i]);
+                             });
+  throughput<Transform>("dualQuat/toTransform", [](In in, unsigned int i) {
+    return dualQuatToTransform(in.dualQuats[i]);
+  });
+  throughput<vec3>("dualQuat/transformPoint", [](In in, unsigned int i) {
+    return transformPoint(in.dualQuats[i], in.points[i]);
+  });
+  throughput<DualQuaternion>("dualQuat/nlerp", [](In in, unsigned int i) {
+    return nlerp(in.dualQuats[i], in.dualQuatsB[i], in.t[i]);
+  });
+  throughput<DualQuaternion>("dualQuat/sclerp", [](In in, unsigned int i) {
+    return sclerp(in.dualQuats[i], in.dualQuatsB[i], in.t[i]);
+  });
+}
+} // namespace
+
+void registerOpBenches() {
+  registerVec3();
+  registerQuat();
+  registerMat4();
+  registerTransform();
+  registerDualQuat();
+}
@@ -0,0 +1,321 @@
+#include "binaryFile.h"
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// Round trips and corrupted images for writeBinaryFile, openBinaryFile and
+// readSection. Returns non-zero when a check fails.
+
+static int failures = 0;
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition);          \
+      ++failures;                                                              \
+    }                                                                          \
+  } while (0)
+
+static std::mt19937 &rng() {
+  static std::mt19937 engine(1234);
+  return engine;
+}
+
+static float randomFloat() {
+  return std::uniform_real_distribution<float>(-100.0f, 100.0f)(rng());
+}
+
+struct Arrays {
+  std::vector<vec3> points;
+  std::vector<quat> rotations;
+  std::vector<mat4> matrices;
+  std::vector<Transform> transforms;
+  std::vector<DualQuaternion> dualQuats;
+};
+
+static void fill(float *f, size_t count, bool smooth) {
+  for (size_t i = 0; i < count; ++i) {
+    f[i] = smooth ? (float)(i % 97) * 0.25f : randomFloat();
+  }
+}
+
+static Arrays makeArrays(unsigned int count, bool smooth) {
+  Arrays a;
+  a.points.resize(count);
+  a.rotations.resize(count);
+  a.matrices.resize(count);
+  a.transforms.resize(count);
+  a.dualQuats.resize(count);
+  fill((float *)a.points.data(), count * 3, smooth);
+  fill((float *)a.rotations.data(), count * 4, smooth);
+  fill((float *)a.matrices.data(), count * 16, smooth);
+  fill((float *)a.transforms.data(), count * 10, smooth);
+  fill((float *)a.dualQuats.data(), count * 8, smooth);
+  return a;
+}
+
+static std::vector<BinarySectionDesc> describe(const Arrays &a,
+                                               BinaryCompression c) {
+  unsigned int n = (unsigned int)a.points.size();
+  return {{1, BinaryType::Vec3, c, a.points.data(), n},
+          {2, BinaryType::Quat, c, a.rotations.data(), n},
+          {3, BinaryType::Mat4, c, a.matrices.data(), n},
+          {4, BinaryType::Transform, c, a.transforms.data(), n},
+          {5, BinaryType::DualQuaternion, c, a.dualQuats.data(), n}};
+}
+
+// The image copied to 64 byte aligned storage, as a mapped file would be
+struct Image {
+  std::vector<unsigned char> storage;
+  unsigned char *data;
+  size_t size;
+
+  explicit Image(const std::vector<unsigned char> &bytes)
+      : storage(bytes.size() + BINARY_FILE_ALIGNMENT), size(bytes.size()) {
+    uintptr_t p = (uintptr_t)storage.data();
+    data = storage.data() + (BINARY_FILE_ALIGNMENT - p % BINARY_FILE_ALIGNMENT);
+    memcpy(data, bytes.data(), bytes.size());
+  }
+};
+
+template <typename T>
+static bool sameAs(const BinaryFile &file, unsigned int id,
+                   const std::vector<T> &expected) {
+  std::vector<T> out(expected.size());
+  return readSection(file, id, out.data(), (unsigned int)out.size()) &&
+         (out.empty() ||
+          memcmp(out.data(), expected.data(), out.size() * sizeof(T)) == 0);
+}
+
+static void checkRoundTrip(const Arrays &a, BinaryCompression c) {
+  std::vector<BinarySectionDesc> desc = describe(a, c);
+  std::vector<unsigned char> bytes;
+  writeBinaryFile(desc.data(), (unsigned int)desc.size(), bytes);
+  Image image(bytes);
+  BinaryFile file;
+  CHECK(openBinaryFile(image.data, image.size, file) == BinaryStatus::Ok);
+  CHECK(sameAs(file, 1, a.points));
+  CHECK(sameAs(file, 2, a.rotations));
+  CHECK(sameAs(file, 3, a.matrices));
+  CHECK(sameAs(file, 4, a.transforms));
+  CHECK(sameAs(file, 5, a.dualQuats));
+
+  const vec3 *points = nullptr;
+  unsigned int count = 0;
+  bool mapped = getSection(file, 1, points, count);
+  CHECK(mapped == (findSection(file, 1)->compression ==
+                   (unsigned int)BinaryCompression::None));
+  if (mapped && count > 0) {
+    CHECK(count == a.points.size());
+    CHECK(memcmp(points, a.points.data(), count * sizeof(vec3)) == 0);
+  }
+  // Wrong type, missing id and too small a buffer
+  std::vector<quat> rotations(a.rotations.size());
+  CHECK(!readSection(file, 1, rotations.data(), (unsigned int)a.points.size()));
+  CHECK(!readSection(file, 9, rotations.data(), (unsigned int)a.points.size()));
+  if (!a.rotations.empty()) {
+    CHECK(!readSection(file, 2, rotations.data(),
+                       (unsigned int)a.rotations.size() - 1));
+  }
+}
+
+static void checkSaveAndMap(const Arrays &a) {
+  std::vector<BinarySectionDesc> desc = describe(a, BinaryCompression::Lz);
+  const char *path = "binaryFileTest.bin";
+  CHECK(saveBinaryFile(path, desc.data(), (unsigned int)desc.size()));
+  MappedFile mappedFile;
+  CHECK(mapFile(path, mappedFile));
+  if (mappedFile.data) {
+    BinaryFile file;
+    CHECK(openBinaryFile(mappedFile.data, mappedFile.size, file) ==
+          BinaryStatus::Ok);
+    CHECK(sameAs(file, 4, a.transforms));
+    unmapFile(mappedFile);
+  }
+  remove(path);
+}
+
+static BinarySectionHeader *sectionTable(Image &image) {
+  return (BinarySectionHeader *)(image.data + sizeof(BinaryFileHeader));
+}
+
+static BinaryStatus openCopy(const Image &image) {
+  BinaryFile file;
+  return openBinaryFile(image.data, image.size, file);
+}
+
+static void checkHeaders(const std::vector<unsigned char> &bytes) {
+  BinaryFile file;
+  Image valid(bytes);
+  for (size_t size = 0; size < bytes.size(); ++size) {
+    BinaryStatus status = openBinaryFile(valid.data, size, file);
+    CHECK(status == BinaryStatus::Truncated);
+  }
+
+  Image image(bytes);
+  BinaryFileHeader *header = (BinaryFileHeader *)image.data;
+  header->magic = 0x12345678u;
+  CHECK(openCopy(image) == BinaryStatus::BadMagic);
+  header->magic = 0x4D415448u;
+  CHECK(openCopy(image) == BinaryStatus::WrongEndianness);
+  header->magic = BINARY_FILE_MAGIC;
+  header->version = BINARY_FILE_VERSION + 1;
+  CHECK(openCopy(image) == BinaryStatus::UnsupportedVersion);
+  header->version = BINARY_FILE_VERSION;
+  header->sectionCount = 0x10000000u;
+  CHECK(openCopy(image) == BinaryStatus::Truncated);
+  header->sectionCount = ((const BinaryFileHeader *)bytes.data())->sectionCount;
+  CHECK(openCopy(image) == BinaryStatus::Ok);
+
+  // One corrupt field of the first section at a time
+  const BinarySectionHeader original = sectionTable(image)[0];
+  auto corrupt = [&](void (*edit)(BinarySectionHeader &)) {
+    BinarySectionHeader &h = sectionTable(image)[0];
+    h = original;
+    edit(h);
+    BinaryStatus status = openCopy(image);
+    h = original;
+    return status;
+  };
+  CHECK(corrupt([](BinarySectionHeader &h) { h.type = 0; }) ==
+        BinaryStatus::BadSection);
+  CHECK(corrupt([](BinarySectionHeader &h) { h.type = 99; }) ==
+        BinaryStatus::BadSection);
+  CHECK(corrupt([](BinarySectionHeader &h) { h.compression = 7; }) ==
+        BinaryStatus::BadSection);
+  CHECK(corrupt([](BinarySectionHeader &h) { h.offset += 4; }) ==
+        BinaryStatus::BadSection);
+  CHECK(corrupt([](BinarySectionHeader &h) { h.offset = 1ull << 40; }) ==
+        BinaryStatus::BadSection);
+  CHECK(corrupt([](BinarySectionHeader &h) { h.size = 1ull << 40; }) ==
+        BinaryStatus::BadSection);
+  CHECK(corrupt([](BinarySectionHeader &h) { h.size = ~0ull; }) ==
+        BinaryStatus::BadSection);
+  CHECK(corrupt([](BinarySectionHeader &h) { h.count = 0xFFFFFFFFu; }) ==
+        BinaryStatus::BadSection);
+  if (original.compression == (unsigned int)BinaryCompression::None) {
+    CHECK(corrupt([](BinarySectionHeader &h) { h.count += 1; }) ==
+          BinaryStatus::BadSection);
+  } else {
+    // Still inside the stream's bound, so only decoding notices
+    sectionTable(image)[0].count = original.count + 1;
+    std::vector<vec3> out(original.count + 1);
+    CHECK(openBinaryFile(image.data, image.size, file) == BinaryStatus::Ok);
+    CHECK(!readSection(file, original.id, out.data(), original.count + 1));
+    sectionTable(image)[0] = original;
+  }
+}
+
+// A compressed section that claims more elements than its stream can hold
+static void checkCompressedCount(const std::vector<unsigned char> &bytes) {
+  Image image(bytes);
+  BinarySectionHeader &h = sectionTable(image)[0];
+  CHECK(h.compression == (unsigned int)BinaryCompression::Lz);
+  h.count = 0xFFFFFFFFu;
+  CHECK(openCopy(image) == BinaryStatus::BadSection);
+  h.count = 0;
+  CHECK(openCopy(image) == BinaryStatus::BadSection);
+}
+
+// Decoding must fail cleanly, not crash or allocate without bound, whatever
+// the bytes are. Accepted sections are bounded by the image size.
+static void checkBitFlips(const std::vector<unsigned char> &bytes,
+                          unsigned int rounds) {
+  std::vector<float> out;
+  for (unsigned int round = 0; round < rounds; ++round) {
+    Image image(bytes);
+    unsigned int flips = 1 + rng()() % 4;
+    for (unsigned int k = 0; k < flips; ++k) {
+      size_t bit = rng()() % (image.size * 8);
+      image.data[bit / 8] ^= (unsigned char)(1u << bit % 8);
+    }
+    BinaryFile file;
+    if (openBinaryFile(image.data, image.size, file) != BinaryStatus::Ok) {
+      continue;
+    }
+    for (unsigned int s = 0; s < file.header->sectionCount; ++s) {
+      const BinarySectionHeader &h = file.sections[s];
+      CHECK(h.count <= (unsigned long long)h.size * 255);
+      out.resize((size_t)h.count * 16);
+      switch ((BinaryType)h.type) {
+      case BinaryType::Vec3:
+        readSection(file, h.id, (vec3 *)out.data(), h.count);
+        break;
+      case BinaryType::Quat:
+        readSection(file, h.id, (quat *)out.data(), h.count);
+        break;
+      case BinaryType::Mat4:
+        readSection(file, h.id, (mat4 *)out.data(), h.count);
+        break;
+      case BinaryType::Transform:
+        readSection(file, h.id, (Transform *)out.data(), h.count);
+        break;
+      case BinaryType::DualQuaternion:
+        readSection(file, h.id, (DualQuaternion *)out.data(), h.count);
+        break;
+      }
+    }
+  }
+}
+
+// Random bytes in the compressed payloads only, which the header checks
+// can not see
+static void checkCorruptStreams(const std::vector<unsigned char> &bytes,
+                                unsigned int rounds) {
+  Image valid(bytes);
+  BinaryFile file;
+  CHECK(openBinaryFile(valid.data, valid.size, file) == BinaryStatus::Ok);
+  CHECK(file.sections[3].compression == (unsigned int)BinaryCompression::Lz);
+  unsigned int count = file.sections[3].count;
+  std::vector<Transform> out(count);
+  for (unsigned int round = 0; round < rounds; ++round) {
+    Image image(bytes);
+    const BinarySectionHeader &h = sectionTable(image)[3];
+    unsigned int edits = 1 + rng()() % 8;
+    for (unsigned int k = 0; k < edits; ++k) {
+      image.data[h.offset + rng()() % h.size] = (unsigned char)rng()();
+    }
+    CHECK(openBinaryFile(image.data, image.size, file) == BinaryStatus::Ok);
+    readSection(file, 4, out.data(), count);
+  }
+  // Cut short
+  Image image(bytes);
+  sectionTable(image)[3].size /= 2;
+  CHECK(openBinaryFile(image.data, image.size, file) == BinaryStatus::Ok);
+  CHECK(!readSection(file, 4, out.data(), count));
+}
+
+int main() {
+  for (unsigned int count : {0u, 1u, 5u, 300u}) {
+    for (bool smooth : {false, true}) {
+      Arrays a = makeArrays(count, smooth);
+      checkRoundTrip(a, BinaryCompression::None);
+      checkRoundTrip(a, BinaryCompression::Lz);
+    }
+  }
+  checkSaveAndMap(makeArrays(1000, true));
+
+  Arrays smooth = makeArrays(200, true);
+  std::vector<unsigned char> plain, packed;
+  std::vector<BinarySectionDesc> desc =
+      describe(smooth, BinaryCompression::None);
+  writeBinaryFile(desc.data(), (unsigned int)desc.size(), plain);
+  desc = describe(smooth, BinaryCompression::Lz);
+  writeBinaryFile(desc.data(), (unsigned int)desc.size(), packed);
+
+  checkHeaders(plain);
+  checkHeaders(packed);
+  checkCompressedCount(packed);
+  checkBitFlips(plain, 5000);
+  checkBitFlips(packed, 20000);
+  checkCorruptStreams(packed, 5000);
+
+  if (failures) {
+    fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  printf("binaryFileTest passed\n");
+  return 0;
+}
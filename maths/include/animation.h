@@ -0,0 +1,78 @@
+#pragma once
+#include "transform.h"
+#include <vector>
+
+enum class Interpolation { Constant, Linear, Cubic };
+enum class TrackTarget { Position = 0, Rotation = 1, Scale = 2 };
+
+// Keys of one track inside the clip's shared arrays. Values have 3 floats
+// per key for position and scale, 4 for rotation; cubic keys store the in
+// tangent, the value and the out tangent back to back.
+struct AnimationTrack {
+  unsigned int firstKey;
+  unsigned int firstValue;
+  unsigned int keyCount;
+  Interpolation interpolation;
+};
+
+// Keyframed position/rotation/scale tracks for jointCount joints. All key
+// times and values live in two contiguous arrays; tracks[joint * 3 + target]
+// locates them. Joints without keys for a target keep whatever the pose
+// already holds when sampled.
+struct AnimationClip {
+  std::vector<float> times;
+  std::vector<float> values;
+  std::vector<AnimationTrack> tracks;
+  float startTime;
+  float endTime;
+  bool looping;
+
+  explicit inline AnimationClip(unsigned int jointCount)
+      : tracks(jointCount * 3, AnimationTrack{0, 0, 0, Interpolation::Linear}),
+        startTime(0.0f), endTime(0.0f), looping(true) {}
+};
+
+// A playing instance for sampleClips. cursor points to one unsigned int per
+// track (clip->tracks.size()), zero initialized, and caches the last key
+// used so sequential playback skips the binary search. It may be null.
+struct ClipSample {
+  const AnimationClip *clip;
+  float time;
+  unsigned int *cursor;
+  Transform *pose;
+};
+
+// Sets the keys of one joint's target. A track that already has keys is
+// replaced, and keyCount 0 removes it; the clip range is rebuilt from the
+// remaining tracks either way.
+void addTrack(AnimationClip &clip, unsigned int joint, TrackTarget target,
+              Interpolation interpolation, const float *times,
+              const float *values, unsigned int keyCount);
+// Wraps time into the clip range when looping, clamps it otherwise.
+float adjustTime(const AnimationClip &clip, float time);
+void sampleClip(const AnimationClip &clip, float time, unsigned int *cursor,
+                Transform *pose);
+void sampleClips(const ClipSample *samples, unsigned int count);
+void sampleClipsParallel(const ClipSample *samples, unsigned int count);
+
+// One input of blendPoses. weight applies to the whole pose; jointWeights,
+// when not null, holds one more factor per joint and works as a mask.
+// Additive layers hold deltas from makeAdditivePose.
+struct PoseLayer {
+  const Transform *pose;
+  float weight;
+  const float *jointWeights;
+  bool additive;
+};
+
+// delta[i] = combine(inverse(reference[i]), pose[i]), so combining the
+// reference with the delta gives the pose back.
+void makeAdditivePose(const Transform *pose, const Transform *reference,
+                      Transform *delta, unsigned int jointCount);
+// Blends any number of layers in one pass over the joints. The normal
+// layers are averaged by weight, rotations on the hemisphere of the first
+// normal layer; a joint that none of them weighs is the identity. Each
+// additive layer is then scaled by its weight and combined on top, in
+// order. out may be the pose of one of the layers.
+void blendPoses(const PoseLayer *layers, unsigned int layerCount,
+                Transform *out, unsigned int jointCount);
@@ -0,0 +1,123 @@
+#pragma once
+#include "dualQuaternion.h"
+#include "transform.h"
+#include <stddef.h>
+#include <vector>
+
+// Binary container for arrays of vec3, quat, mat4, Transform and
+// DualQuaternion. The file is a BinaryFileHeader, a table of
+// BinarySectionHeaders and the section payloads, each starting on a
+// BINARY_FILE_ALIGNMENT boundary. Uncompressed payloads are the arrays
+// exactly as they sit in memory, so a mapped file is used in place.
+//
+// Files are written in the byte order of the machine writing them; a reader
+// with the other byte order gets BinaryStatus::WrongEndianness.
+#define BINARY_FILE_MAGIC 0x4854414Du // "MATH" in little endian
+#define BINARY_FILE_VERSION 1u
+#define BINARY_FILE_ALIGNMENT 64u
+
+enum class BinaryType { Vec3 = 1, Quat, Mat4, Transform, DualQuaternion };
+
+// Lz shuffles the float bytes into planes (sign and exponent bytes end up
+// together) before a byte-oriented LZ77 pass. It is lossless, but a
+// compressed section is decoded with readSection instead of used in place.
+// Sections that do not get smaller are stored uncompressed.
+enum class BinaryCompression { None = 0, Lz = 1 };
+
+enum class BinaryStatus {
+  Ok,
+  Truncated,
+  BadMagic,
+  WrongEndianness,
+  UnsupportedVersion,
+  BadSection,
+};
+
+struct BinaryFileHeader {
+  unsigned int magic;
+  unsigned int version;
+  unsigned int sectionCount;
+  unsigned int reserved;
+  unsigned long long fileSize;
+};
+
+// offset is from the start of the file; size is the stored size, which for
+// uncompressed sections is count * the element size.
+struct BinarySectionHeader {
+  unsigned int id;
+  unsigned int type;
+  unsigned int compression;
+  unsigned int count;
+  unsigned long long offset;
+  unsigned long long size;
+};
+
+// A section to write. id is the caller's name for it, looked up again with
+// findSection.
+struct BinarySectionDesc {
+  unsigned int id;
+  BinaryType type;
+  BinaryCompression compression;
+  const void *data;
+  unsigned int count;
+};
+
+void writeBinaryFile(const BinarySectionDesc *sections,
+                     unsigned int sectionCount,
+                     std::vector<unsigned char> &out);
+bool saveBinaryFile(const char *path, const BinarySectionDesc *sections,
+                    unsigned int sectionCount);
+
+// A validated view of a file image. data must stay alive and, for zero-copy
+// access, be aligned to BINARY_FILE_ALIGNMENT (mapped files always are).
+struct BinaryFile {
+  const unsigned char *data;
+  size_t size;
+  const BinaryFileHeader *header;
+  const BinarySectionHeader *sections;
+};
+
+// Checks the header and that every section lies inside the image with a
+// known type and a count its stored size can hold; nothing is decoded.
+BinaryStatus openBinaryFile(const void *data, size_t size, BinaryFile &file);
+// The first section with the given id, or null.
+const BinarySectionHeader *findSection(const BinaryFile &file,
+                                       unsigned int id);
+
+// Zero-copy access to an uncompressed section of the matching type. False,
+// with data and count left alone, when the section is missing, compressed,
+// of another type or not aligned for it.
+bool getSection(const BinaryFile &file, unsigned int id, const vec3 *&data,
+                unsigned int &count);
+bool getSection(const BinaryFile &file, unsigned int id, const quat *&data,
+                unsigned int &count);
+bool getSection(const BinaryFile &file, unsigned int id, const mat4 *&data,
+                unsigned int &count);
+bool getSection(const BinaryFile &file, unsigned int id,
+                const Transform *&data, unsigned int &count);
+bool getSection(const BinaryFile &file, unsigned int id,
+                const DualQuaternion *&data, unsigned int &count);
+
+// Copies or decodes a section of the matching type into out, which has room
+// for capacity elements. False when the section is missing, of another type,
+// holds more than capacity elements or its compressed data is corrupt.
+bool readSection(const BinaryFile &file, unsigned int id, vec3 *out,
+                 unsigned int capacity);
+bool readSection(const BinaryFile &file, unsigned int id, quat *out,
+                 unsigned int capacity);
+bool readSection(const BinaryFile &file, unsigned int id, mat4 *out,
+                 unsigned int capacity);
+bool readSection(const BinaryFile &file, unsigned int id, Transform *out,
+                 unsigned int capacity);
+bool readSection(const BinaryFile &file, unsigned int id,
+                 DualQuaternion *out, unsigned int capacity);
+
+// Read-only memory mapping of a whole file.
+struct MappedFile {
+  const void *data;
+  size_t size;
+  void *handle;
+};
+
+bool mapFile(const char *path, MappedFile &file);
+void unmapFile(MappedFile &file);
@@ -0,0 +1,66 @@
+#pragma once
+#include "dualQuaternion.h"
+#include "mat4.h"
+
+// Axis aligned box. The empty box has min > max; merging anything into it
+// yields the other operand.
+struct Aabb {
+  vec3 min;
+  vec3 max;
+};
+
+// The empty sphere has a negative radius.
+struct Sphere {
+  vec3 center;
+  float radius;
+};
+
+Aabb emptyAabb();
+bool isEmpty(const Aabb &b);
+Aabb merge(const Aabb &a, const Aabb &b);
+Aabb merge(const Aabb &b, const vec3 &p);
+
+// Arvo's method: the box around the transformed box, from the matrix and the
+// two corners alone. Empty boxes stay empty.
+Aabb transformAabb(const mat4 &m, const Aabb &b);
+Aabb transformAabb(const Transform &t, const Aabb &b);
+// Centre transformed, radius scaled by the largest axis scale.
+Sphere transformSphere(const mat4 &m, const Sphere &s);
+// out[i] = transformAabb(m[i], in[i]); out may alias in.
+void transformAabbs(const mat4 *m, const Aabb *in, Aabb *out,
+                    unsigned int count);
+
+// Bounds of point sets, optionally after transformation by m, t or dq. The
+// points are not written back. The sphere is centred on the box, which is
+// not minimal but needs only a second pass. Empty inputs give the empty box
+// and sphere.
+Aabb computeAabb(const vec3 *points, unsigned int count);
+Aabb computeAabb(const Vec3SoA &points, unsigned int count);
+Aabb computeAabb(const mat4 &m, const vec3 *points, unsigned int count);
+Aabb computeAabb(const Transform &t, const vec3 *points, unsigned int count);
+Aabb computeAabb(const DualQuaternion &dq, const vec3 *points,
+                 unsigned int count);
+Sphere computeSphere(const vec3 *points, unsigned int count);
+Sphere computeSphere(const mat4 &m, const vec3 *points, unsigned int count);
+Sphere computeSphere(const Transform &t, const vec3 *points,
+                     unsigned int count);
+Sphere computeSphere(const DualQuaternion &dq, const vec3 *points,
+                     unsigned int count);
+// The same over parallelFor; grain 0 picks a default.
+Aabb computeAabbParallel(const vec3 *points, unsigned int count,
+                         unsigned int grain = 0);
+Aabb computeAabbParallel(const mat4 &m, const vec3 *points, unsigned int count,
+                         unsigned int grain = 0);
+Sphere computeSphereParallel(const vec3 *points, unsigned int count,
+                             unsigned int grain = 0);
+Sphere computeSphereParallel(const mat4 &m, const vec3 *points,
+                             unsigned int count, unsigned int grain = 0);
+
+// The box around count boxes.
+Aabb computeAabb(const Aabb *boxes, unsigned int count);
+// merged[i] is the union of bounds[i] and the bounds of all its descendants,
+// with every box in the same space. parents follows computeWorldTransforms:
+// parents come before their children and negative marks a root. merged may
+// alias bounds.
+void mergeHierarchyBounds(const Aabb *bounds, const int *parents,
+                          Aabb *merged, unsigned int count);
@@ -0,0 +1,70 @@
+#pragma once
+#include "ray.h"
+#include <vector>
+
+// Four-wide bounding volume hierarchy. Every node holds the boxes of up to
+// four children side by side, so queries test them in one SIMD pass. A child
+// is an inner node (count 0, child is its node index), a leaf (count
+// primitives starting at child in Bvh::primitives) or unused (count 0, child
+// negative).
+struct alignas(64) BvhNode {
+  float minX[4], minY[4], minZ[4];
+  float maxX[4], maxY[4], maxZ[4];
+  int child[4];
+  unsigned int count[4];
+};
+
+// nodes[0] is the root and children always come after their parents.
+// primitives maps leaf order to the caller's primitive indices, and boxes
+// holds the primitive boxes in leaf order.
+struct Bvh {
+  std::vector<BvhNode> nodes;
+  std::vector<unsigned int> primitives;
+  std::vector<Aabb> boxes;
+};
+
+// Binned SAH build over primitive boxes, or over triangles given as in
+// intersectTriangles. The Parallel versions build the subtrees below the top
+// levels as separate parallelFor tasks.
+void buildBvh(Bvh &bvh, const Aabb *boxes, unsigned int count);
+void buildBvh(Bvh &bvh, const vec3 *vertices, const unsigned int *indices,
+              unsigned int triangleCount);
+void buildBvhParallel(Bvh &bvh, const Aabb *boxes, unsigned int count);
+void buildBvhParallel(Bvh &bvh, const vec3 *vertices,
+                      const unsigned int *indices, unsigned int triangleCount);
+
+// Refit keeps the tree and recomputes every box bottom-up, for primitives
+// that moved since the build. The inputs are indexed like the build input:
+// new primitive boxes, moved triangle vertices, or object space boxes placed
+// by per-primitive transforms (with transformAabb).
+void refitBvh(Bvh &bvh, const Aabb *boxes);
+void refitBvh(Bvh &bvh, const vec3 *vertices, const unsigned int *indices);
+void refitBvh(Bvh &bvh, const Aabb *localBoxes, const mat4 *transforms);
+void refitBvh(Bvh &bvh, const Aabb *localBoxes, const Transform *transforms);
+
+// Nearest ray hit against the primitive boxes, or against the triangles the
+// tree was built from, with the same conventions as intersectAabbs and
+// intersectTriangles.
+RayHit intersectBvh(const Bvh &bvh, const Ray &ray, float maxT);
+RayHit intersectBvh(const Bvh &bvh, const Ray &ray, const vec3 *vertices,
+                    const unsigned int *indices, float maxT);
+
+// Writes the indices of the primitives whose boxes overlap box to out, up to
+// capacity of them, and returns how many there are in total.
+unsigned int overlapBvh(const Bvh &bvh, const Aabb &box, unsigned int *out,
+                        unsigned int capacity);
+
+// The primitive closest to point within maxDistance, measured to the
+// primitive boxes or to the triangles. index is RAY_NO_HIT when there is none.
+struct BvhNearest {
+  vec3 point;
+  float distanceSq;
+  unsigned int index;
+};
+
+BvhNearest nearestBvh(const Bvh &bvh, const vec3 &point, float maxDistance);
+BvhNearest nearestBvh(const Bvh &bvh, const vec3 &point, const vec3 *vertices,
+                      const unsigned int *indices, float maxDistance);
+// Closest point to p on the triangle abc.
+vec3 closestPointOnTriangle(const vec3 &p, const vec3 &a, const vec3 &b,
+                            const vec3 &c);
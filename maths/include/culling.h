@@ -0,0 +1,37 @@
+#pragma once
+#include "mat4.h"
+
+// A point p is on the inner side when dot(normal, p) + distance >= 0.
+struct Plane {
+  vec3 normal;
+  float distance;
+};
+
+// Left, right, bottom, top, near and far planes with unit normals pointing
+// into the volume.
+struct Frustum {
+  Plane planes[6];
+};
+
+// Gribb/Hartmann extraction from a view-projection matrix with OpenGL clip
+// space (-w <= z <= w), as produced by perspective, frustum and ortho.
+Frustum extractFrustum(const mat4 &viewProjection);
+
+// Conservative tests: true unless the volume is entirely outside one plane.
+bool intersectsSphere(const Frustum &f, const vec3 &center, float radius);
+bool intersectsAabb(const Frustum &f, const vec3 &min, const vec3 &max);
+
+// Batch culling over structure-of-arrays bounds. The indices of the visible
+// elements are written in ascending order to visible, which needs room for
+// count entries; the return value is how many were written.
+unsigned int cullSpheres(const Frustum &f, const Vec3SoA &centers,
+                         const float *radii, unsigned int count,
+                         unsigned int *visible);
+unsigned int cullAabbs(const Frustum &f, const Vec3SoA &min, const Vec3SoA &max,
+                       unsigned int count, unsigned int *visible);
+unsigned int cullSpheresParallel(const Frustum &f, const Vec3SoA &centers,
+                                 const float *radii, unsigned int count,
+                                 unsigned int *visible);
+unsigned int cullAabbsParallel(const Frustum &f, const Vec3SoA &min,
+                               const Vec3SoA &max, unsigned int count,
+                               unsigned int *visible);
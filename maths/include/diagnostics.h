@@ -0,0 +1,40 @@
+#pragma once
+#include "mathsConfig.h"
+
+// Counters for degenerate inputs that the library silently replaces with a
+// fallback (usually the identity). They are compiled in only when
+// MATHS_DIAGNOSTICS is defined, which the MATHS_ENABLE_DIAGNOSTICS CMake
+// option does; otherwise MATHS_COUNT expands to nothing and
+// readDiagnostics() reports zeros.
+enum class Diagnostic {
+  SingularInverse,       // inverse, tryInverse, invert, batch inverse
+  SingularInverseAffine, // inverseAffine, tryInverseAffine, batch variant
+  DegenerateFrustum,     // frustum and perspective
+  DegenerateOrtho,
+  DegenerateLookAt,
+  Count
+};
+
+struct DiagnosticCounts {
+  unsigned long long counts[(int)Diagnostic::Count];
+};
+
+// Snapshot of every counter, optionally zeroing them as they are read so a
+// periodic scrape sees the events since the previous one. Safe to call from
+// any thread.
+DiagnosticCounts readDiagnostics(bool reset = false);
+const char *diagnosticName(Diagnostic counter);
+
+#ifdef MATHS_DIAGNOSTICS
+// Relaxed atomic increment, only reached on the degenerate branches.
+void countDiagnostic(Diagnostic counter);
+
+#ifdef MATHS_CONSTANT_EVALUATED
+#define MATHS_COUNT(counter)                                                   \
+  (MATHS_CONSTANT_EVALUATED() ? (void)0 : countDiagnostic(counter))
+#else
+#define MATHS_COUNT(counter) countDiagnostic(counter)
+#endif
+#else
+#define MATHS_COUNT(counter) ((void)0)
+#endif
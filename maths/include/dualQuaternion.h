@@ -1,6 +1,9 @@
 #pragma once
 #include "quat.h"
 #include "transform.h"
+
+#define DUALQUAT_EPSILON 0.000001f
+
 struct DualQuaternion {
   union {
     struct {
@@ -19,8 +22,25 @@ struct DualQuaternion {
   }
 };
 
+// Rotation and the translation extracted from a unit dual quaternion, so
+// points can be transformed without another quaternion product.
+struct CachedDualQuaternion {
+  quat real;
+  vec3 translation;
+  inline CachedDualQuaternion() : real(quat()), translation(vec3()) {}
+  inline CachedDualQuaternion(const quat &r, const vec3 &t)
+      : real(r), translation(t) {}
+};
+
+// Operands normalizes both inputs like operator*, Result normalizes only the
+// product, None assumes both inputs are already unit length.
+enum class DualQuatNormalize { Operands, Result, None };
+
 DualQuaternion operator+(const DualQuaternion &l, const DualQuaternion &r);
 DualQuaternion operator*(const DualQuaternion &l, const DualQuaternion &r);
+DualQuaternion mulUnchecked(const DualQuaternion &l, const DualQuaternion &r);
+DualQuaternion mul(const DualQuaternion &l, const DualQuaternion &r,
+                   DualQuatNormalize policy);
 DualQuaternion operator*(const DualQuaternion &dq, float f);
 bool operator==(const DualQuaternion &l, const DualQuaternion &r);
 bool operator!=(const DualQuaternion &l, const DualQuaternion &r);
@@ -29,6 +49,36 @@ DualQuaternion conjugate(const DualQuaternion &dq);
 DualQuaternion normalized(const DualQuaternion &dq);
 void normalize(DualQuaternion &dq);
 DualQuaternion transformToDualQuat(const Transform &t);
+void transformToDualQuat(const Transform *in, DualQuaternion *out,
+                         unsigned int count);
 Transform dualQuatToTransform(const DualQuaternion &dq);
+void dualQuatToTransform(const DualQuaternion *in, Transform *out,
+                         unsigned int count);
+// The conversions over parallelFor; grain 0 picks a default.
+void transformToDualQuatParallel(const Transform *in, DualQuaternion *out,
+                                 unsigned int count, unsigned int grain = 0);
+void dualQuatToTransformParallel(const DualQuaternion *in, Transform *out,
+                                 unsigned int count, unsigned int grain = 0);
 vec3 transformVector(const DualQuaternion &dq, const vec3 &v);
 vec3 transformPoint(const DualQuaternion &dq, const vec3 &v);
+CachedDualQuaternion cacheDualQuat(const DualQuaternion &dq);
+vec3 transformVector(const CachedDualQuaternion &dq, const vec3 &v);
+vec3 transformPoint(const CachedDualQuaternion &dq, const vec3 &v);
+DualQuaternion nlerp(const DualQuaternion &from, const DualQuaternion &to,
+                     float t);
+DualQuaternion sclerp(const DualQuaternion &from, const DualQuaternion &to,
+                      float t);
+
+// Batch versions. t is shared by every pair; out may alias the inputs.
+void cacheDualQuat(const DualQuaternion *in, CachedDualQuaternion *out,
+                   unsigned int count);
+void transformPoints(const CachedDualQuaternion &dq, const vec3 *in, vec3 *out,
+                     unsigned int count);
+void nlerp(const DualQuaternion *from, const DualQuaternion *to, float t,
+           DualQuaternion *out, unsigned int count);
+void sclerp(const DualQuaternion *from, const DualQuaternion *to, float t,
+            DualQuaternion *out, unsigned int count);
+
+#ifdef MATHS_HEADER_ONLY
+#include "dualQuaternion.inl"
+#endif
@@ -0,0 +1,147 @@
+#pragma once
+#include <math.h>
+MATHS_INLINE DualQuaternion operator+(const DualQuaternion &l,
+                                      const DualQuaternion &r) {
+  return DualQuaternion(l.parts.real + r.parts.real,
+                        l.parts.dual + r.parts.dual);
+}
+
+MATHS_INLINE DualQuaternion operator*(const DualQuaternion &dq, float f) {
+  return DualQuaternion(dq.parts.real * f, dq.parts.dual * f);
+}
+
+MATHS_INLINE DualQuaternion operator*(const DualQuaternion &l,
+                                      const DualQuaternion &r) {
+  DualQuaternion lhs = normalized(l);
+  DualQuaternion rhs = normalized(r);
+  return mulUnchecked(lhs, rhs);
+}
+
+MATHS_INLINE DualQuaternion mulUnchecked(const DualQuaternion &l,
+                                         const DualQuaternion &r) {
+  return DualQuaternion(l.parts.real * r.parts.real,
+                        l.parts.real * r.parts.dual +
+                            l.parts.dual * r.parts.real);
+}
+
+MATHS_INLINE DualQuaternion mul(const DualQuaternion &l,
+                                const DualQuaternion &r,
+                                DualQuatNormalize policy) {
+  switch (policy) {
+  case DualQuatNormalize::Operands:
+    return l * r;
+  case DualQuatNormalize::Result:
+    return normalized(mulUnchecked(l, r));
+  default:
+    return mulUnchecked(l, r);
+  }
+}
+MATHS_INLINE bool operator==(const DualQuaternion &l, const DualQuaternion &r) {
+  return l.parts.real == r.parts.real && l.parts.dual == r.parts.dual;
+}
+MATHS_INLINE bool operator!=(const DualQuaternion &l, const DualQuaternion &r) {
+  return l.parts.real != r.parts.real || l.parts.dual != r.parts.dual;
+}
+
+MATHS_INLINE float dot(const DualQuaternion &l, const DualQuaternion &r) {
+  return dot(l.parts.real, r.parts.real);
+}
+MATHS_INLINE DualQuaternion conjugate(const DualQuaternion &dq) {
+  return DualQuaternion(conjugate(dq.parts.real), conjugate(dq.parts.dual));
+}
+MATHS_INLINE DualQuaternion normalized(const DualQuaternion &dq) {
+  float magSq = dot(dq.parts.real, dq.parts.real);
+  if (magSq < 0.000001f) {
+    return DualQuaternion();
+  }
+  float invMag = 1.0f / sqrtf(magSq);
+  return DualQuaternion(dq.parts.real * invMag, dq.parts.dual * invMag);
+}
+MATHS_INLINE void normalize(DualQuaternion &dq) {
+  float magSq = dot(dq.parts.real, dq.parts.real);
+  if (magSq < 0.000001f) {
+    return;
+  }
+  float invMag = 1.0f / sqrtf(magSq);
+  dq.parts.real = dq.parts.real * invMag;
+  dq.parts.dual = dq.parts.dual * invMag;
+}
+
+MATHS_INLINE DualQuaternion transformToDualQuat(const Transform &t) {
+  quat d(t.position.x, t.position.y, t.position.z, 0);
+  quat qr = t.rotation;
+  quat qd = qr * d * 0.5f;
+  return DualQuaternion(qr, qd);
+}
+MATHS_INLINE Transform dualQuatToTransform(const DualQuaternion &dq) {
+  Transform result;
+  result.rotation = dq.parts.real;
+  quat d = conjugate(dq.parts.real) * (dq.parts.dual * 2.0f);
+  result.position = vec3(d.x, d.y, d.z);
+  return result;
+}
+
+MATHS_INLINE vec3 transformVector(const DualQuaternion &dq, const vec3 &v) {
+  return dq.parts.real * v;
+}
+
+MATHS_INLINE vec3 transformPoint(const DualQuaternion &dq, const vec3 &v) {
+  quat d = conjugate(dq.parts.real) * (dq.parts.dual * 2.0f);
+  vec3 t = vec3(d.x, d.y, d.z);
+  return dq.parts.real * v + t;
+}
+
+MATHS_INLINE CachedDualQuaternion cacheDualQuat(const DualQuaternion &dq) {
+  quat d = conjugate(dq.parts.real) * (dq.parts.dual * 2.0f);
+  return CachedDualQuaternion(dq.parts.real, vec3(d.x, d.y, d.z));
+}
+
+MATHS_INLINE vec3 transformVector(const CachedDualQuaternion &dq,
+                                  const vec3 &v) {
+  return dq.real * v;
+}
+
+MATHS_INLINE vec3 transformPoint(const CachedDualQuaternion &dq,
+                                 const vec3 &v) {
+  return dq.real * v + dq.translation;
+}
+
+MATHS_INLINE DualQuaternion nlerp(const DualQuaternion &from,
+                                  const DualQuaternion &to, float t) {
+  float w = dot(from.parts.real, to.parts.real) < 0.0f ? -t : t;
+  return normalized(from * (1.0f - t) + to * w);
+}
+
+// Screw linear interpolation: from * delta^t, with delta the shortest screw
+// motion from `from` to `to`. Both inputs must be unit dual quaternions.
+MATHS_INLINE DualQuaternion sclerp(const DualQuaternion &from,
+                                   const DualQuaternion &to, float t) {
+  DualQuaternion delta = mulUnchecked(conjugate(from), to);
+  if (delta.parts.real.w < 0.0f) {
+    delta = delta * -1.0f;
+  }
+  quat r = delta.parts.real;
+  quat d = delta.parts.dual;
+
+  float halfSin = len(r.data.vector);
+  if (halfSin < DUALQUAT_EPSILON) {
+    // Pure translation: the dual part scales linearly
+    return normalized(mulUnchecked(from, DualQuaternion(quat(), d * t)));
+  }
+
+  // Screw axis l, moment m, half angle and pitch, each scaled by t
+  float halfAngle = atan2f(halfSin, r.w);
+  vec3 l = r.data.vector * (1.0f / halfSin);
+  float pitch = -2.0f * d.w / halfSin;
+  vec3 m = (d.data.vector - l * (pitch * 0.5f * r.w)) * (1.0f / halfSin);
+
+  halfAngle *= t;
+  pitch *= t;
+  float s = sinf(halfAngle);
+  float c = cosf(halfAngle);
+  vec3 realVec = l * s;
+  vec3 dualVec = m * s + l * (pitch * 0.5f * c);
+  DualQuaternion step(quat(realVec.x, realVec.y, realVec.z, c),
+                      quat(dualVec.x, dualVec.y, dualVec.z, -pitch * 0.5f * s));
+  return normalized(mulUnchecked(from, step));
+}
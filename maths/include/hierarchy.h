@@ -0,0 +1,27 @@
+#pragma once
+#include "transform.h"
+
+// World pose propagation over a parent index array. Joints must be sorted so
+// that every parent comes before its children; a negative parent index marks
+// a root.
+//
+// The instanceCount versions evaluate that many copies of the same hierarchy
+// stored back to back (local[instance * jointCount + joint]), four instances
+// per SIMD pass. The Parallel versions split instances across threads, or the
+// levels of a single wide hierarchy when instanceCount is 1.
+void computeWorldTransforms(const Transform *local, const int *parents,
+                            Transform *world, unsigned int jointCount);
+void computeWorldMatrices(const Transform *local, const int *parents,
+                          mat4 *world, unsigned int jointCount);
+void computeWorldTransforms(const Transform *local, const int *parents,
+                            Transform *world, unsigned int jointCount,
+                            unsigned int instanceCount);
+void computeWorldMatrices(const Transform *local, const int *parents,
+                          mat4 *world, unsigned int jointCount,
+                          unsigned int instanceCount);
+void computeWorldTransformsParallel(const Transform *local, const int *parents,
+                                    Transform *world, unsigned int jointCount,
+                                    unsigned int instanceCount);
+void computeWorldMatricesParallel(const Transform *local, const int *parents,
+                                  mat4 *world, unsigned int jointCount,
+                                  unsigned int instanceCount);
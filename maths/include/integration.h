@@ -0,0 +1,53 @@
+#pragma once
+#include "quat.h"
+
+// Fixed-step rigid body integration over arrays of bodies. Angular
+// velocities are in world space, in radians per second: a body spinning at w
+// turns by |w| * dt about w during the step, which is q * angleAxis(|w| * dt,
+// w) for an orientation q. Orientations are renormalized after each step.
+// Orientations and velocities may not alias.
+
+// First order: q + q * quat(w.x, w.y, w.z, 0) * (dt / 2), normalized. The
+// cheapest step, but it turns a little less than |w| * dt, increasingly so
+// as |w| * dt grows.
+void integrateOrientations(quat *orientations, const vec3 *angularVelocities,
+                           float dt, unsigned int count);
+void integrateOrientations(const QuatSoA &orientations,
+                           const Vec3SoA &angularVelocities, float dt,
+                           unsigned int count);
+// Exponential map: q * angleAxis(|w| * dt, w), exact for an angular velocity
+// that is constant over the step. Steps of more than half a turn are rare
+// and go through sinf and cosf.
+void integrateOrientationsExp(quat *orientations,
+                              const vec3 *angularVelocities, float dt,
+                              unsigned int count);
+void integrateOrientationsExp(const QuatSoA &orientations,
+                              const Vec3SoA &angularVelocities, float dt,
+                              unsigned int count);
+// positions += velocities * dt
+void integratePositions(vec3 *positions, const vec3 *velocities, float dt,
+                        unsigned int count);
+void integratePositions(const Vec3SoA &positions, const Vec3SoA &velocities,
+                        float dt, unsigned int count);
+
+// The same spread over parallelFor; grain 0 picks a default.
+void integrateOrientationsParallel(quat *orientations,
+                                   const vec3 *angularVelocities, float dt,
+                                   unsigned int count, unsigned int grain = 0);
+void integrateOrientationsParallel(const QuatSoA &orientations,
+                                   const Vec3SoA &angularVelocities, float dt,
+                                   unsigned int count, unsigned int grain = 0);
+void integrateOrientationsExpParallel(quat *orientations,
+                                      const vec3 *angularVelocities, float dt,
+                                      unsigned int count,
+                                      unsigned int grain = 0);
+void integrateOrientationsExpParallel(const QuatSoA &orientations,
+                                      const Vec3SoA &angularVelocities,
+                                      float dt, unsigned int count,
+                                      unsigned int grain = 0);
+void integratePositionsParallel(vec3 *positions, const vec3 *velocities,
+                                float dt, unsigned int count,
+                                unsigned int grain = 0);
+void integratePositionsParallel(const Vec3SoA &positions,
+                                const Vec3SoA &velocities, float dt,
+                                unsigned int count, unsigned int grain = 0);
@@ -1,4 +1,6 @@
 #pragma once
+#include "diagnostics.h"
+#include "mathsConfig.h"
 #include "vec3.h"
 #include "vec4.h"
 #include <ostream>
@@ -71,23 +73,23 @@ struct mat4 {
       float r3c3;
     };
   };
-  inline mat4()
+  constexpr mat4()
       : xx(1), xy(0), xz(0), xw(0), //
         yx(0), yy(1), yz(0), yw(0), //
         zx(0), zy(0), zz(1), zw(0), //
         tx(0), ty(0), tz(0), tw(1)  //
   {}
-  inline mat4(float *fv)
+  constexpr mat4(float *fv)
       : xx(fv[0]), xy(fv[1]), xz(fv[2]), xw(fv[3]),    //
         yx(fv[4]), yy(fv[5]), yz(fv[6]), yw(fv[7]),    //
         zx(fv[8]), zy(fv[9]), zz(fv[10]), zw(fv[11]),  //
         tx(fv[12]), ty(fv[13]), tz(fv[14]), tw(fv[15]) //
   {}
-  inline mat4(float _00, float _01, float _02, float _03, //
-              float _10, float _11, float _12, float _13, //
-              float _20, float _21, float _22, float _23, //
-              float _30, float _31, float _32, float _33  //
-              )
+  constexpr mat4(float _00, float _01, float _02, float _03, //
+                 float _10, float _11, float _12, float _13, //
+                 float _20, float _21, float _22, float _23, //
+                 float _30, float _31, float _32, float _33  //
+                 )
       : xx(_00), xy(_01), xz(_02), xw(_03), //
         yx(_10), yy(_11), yz(_12), yw(_13), //
         zx(_20), zy(_21), zz(_22), zw(_23), //
@@ -95,24 +97,167 @@ struct mat4 {
   {}
 };
 
-mat4 operator+(const mat4 &a, const mat4 &b);
-mat4 operator*(const mat4 &a, float f);
-mat4 operator*(const mat4 &a, const mat4 &b);
-vec4 operator*(const mat4 &m, const vec4 &v);
+#ifndef MATHS_HEADER_ONLY
+// Runtime path of operator*(mat4, mat4), through the SIMD kernels.
+mat4 mulKernel(const mat4 &a, const mat4 &b);
+#endif
+
+// constexpr arithmetic, defined here in every build mode. Elements are read
+// through the xx..tw names, the union member the constructors initialize;
+// M4E(m, c, r) is column c (x, y, z, t) and row r (x, y, z, w).
+#define M4E(m, c, r) m.c##r
+#define M4D(c, r)                                                              \
+  M4E(a, x, r) * M4E(b, c, x) + M4E(a, y, r) * M4E(b, c, y) +                  \
+      M4E(a, z, r) * M4E(b, c, z) + M4E(a, t, r) * M4E(b, c, w)
+#define M4V4D(r, vx, vy, vz, vw)                                               \
+  M4E(m, x, r) * vx + M4E(m, y, r) * vy + M4E(m, z, r) * vz + M4E(m, t, r) * vw
+
+constexpr mat4 operator+(const mat4 &a, const mat4 &b) {
+  return mat4(a.xx + b.xx, a.xy + b.xy, a.xz + b.xz, a.xw + b.xw, //
+              a.yx + b.yx, a.yy + b.yy, a.yz + b.yz, a.yw + b.yw, //
+              a.zx + b.zx, a.zy + b.zy, a.zz + b.zz, a.zw + b.zw, //
+              a.tx + b.tx, a.ty + b.ty, a.tz + b.tz, a.tw + b.tw  //
+  );
+}
+
+constexpr mat4 operator*(const mat4 &a, float f) {
+  return mat4(a.xx * f, a.xy * f, a.xz * f, a.xw * f, //
+              a.yx * f, a.yy * f, a.yz * f, a.yw * f, //
+              a.zx * f, a.zy * f, a.zz * f, a.zw * f, //
+              a.tx * f, a.ty * f, a.tz * f, a.tw * f  //
+  );
+}
+
+constexpr mat4 operator*(const mat4 &a, const mat4 &b) {
+#if !defined(MATHS_HEADER_ONLY) && defined(MATHS_CONSTANT_EVALUATED)
+  if (!MATHS_CONSTANT_EVALUATED()) {
+    return mulKernel(a, b);
+  }
+#endif
+  return mat4(M4D(x, x), M4D(x, y), M4D(x, z), M4D(x, w), // Column 0
+              M4D(y, x), M4D(y, y), M4D(y, z), M4D(y, w), // Column 1
+              M4D(z, x), M4D(z, y), M4D(z, z), M4D(z, w), // Column 2
+              M4D(t, x), M4D(t, y), M4D(t, z), M4D(t, w)  // Column 3
+  );
+}
+
+constexpr vec4 operator*(const mat4 &m, const vec4 &v) {
+  return vec4(M4V4D(x, v.x, v.y, v.z, v.w), //
+              M4V4D(y, v.x, v.y, v.z, v.w), //
+              M4V4D(z, v.x, v.y, v.z, v.w), //
+              M4V4D(w, v.x, v.y, v.z, v.w));
+}
+
+constexpr vec3 transformVector(const mat4 &m, const vec3 &v) {
+  return vec3(M4V4D(x, v.x, v.y, v.z, 0.0f), //
+              M4V4D(y, v.x, v.y, v.z, 0.0f), //
+              M4V4D(z, v.x, v.y, v.z, 0.0f));
+}
+
+constexpr vec3 transformPoint(const mat4 &m, const vec3 &v) {
+  return vec3(M4V4D(x, v.x, v.y, v.z, 1.0f), //
+              M4V4D(y, v.x, v.y, v.z, 1.0f), //
+              M4V4D(z, v.x, v.y, v.z, 1.0f));
+}
+
+constexpr vec3 transformPoint(const mat4 &m, const vec3 &v, float &w) {
+  float _w = w;
+  w = M4V4D(w, v.x, v.y, v.z, _w);
+  return vec3(M4V4D(x, v.x, v.y, v.z, _w), //
+              M4V4D(y, v.x, v.y, v.z, _w), //
+              M4V4D(z, v.x, v.y, v.z, _w));
+}
+
+constexpr mat4 transposed(const mat4 &m) {
+  return mat4(m.xx, m.yx, m.zx, m.tx, //
+              m.xy, m.yy, m.zy, m.ty, //
+              m.xz, m.yz, m.zz, m.tz, //
+              m.xw, m.yw, m.zw, m.tw);
+}
+
+// Invalid planes (l == r, t == b or n == f) give the identity matrix.
+constexpr mat4 frustum(float l, float r, float b, float t, float n, float f) {
+  if (l == r || t == b || n == f) {
+    MATHS_COUNT(Diagnostic::DegenerateFrustum);
+    return mat4();
+  }
+  return mat4((2.0f * n) / (r - l), 0, 0, 0, 0, (2.0f * n) / (t - b), 0, 0,
+              (r + l) / (r - l), (t + b) / (t - b), (-(f + n)) / (f - n), -1, 0,
+              0, (-2 * f * n) / (f - n), 0);
+}
+
+constexpr mat4 ortho(float l, float r, float b, float t, float n, float f) {
+  if (l == r || t == b || n == f) {
+    MATHS_COUNT(Diagnostic::DegenerateOrtho);
+    return mat4();
+  }
+  return mat4(2.0f / (r - l), 0, 0, 0,  //
+              0, 2.0f / (t - b), 0, 0,  //
+              0, 0, -2.0f / (f - n), 0, //
+              -((r + l) / (r - l)), -((t + b) / (t - b)), -((f + n) / (f - n)),
+              1);
+}
+
+#undef M4E
+#undef M4D
+#undef M4V4D
 
 bool operator==(const mat4 &a, const mat4 &b);
 bool operator!=(const mat4 &a, const mat4 &b);
-vec3 transformVector(const mat4 &m, const vec3 &v);
-vec3 transformPoint(const mat4 &m, const vec3 &v);
-vec3 transformPoint(const mat4 &m, const vec3 &v, float &w);
+
+// Batch versions of the above. in and out may alias; w is read and written
+// per point like the single point version.
+void transformVectors(const mat4 &m, const vec3 *in, vec3 *out,
+                      unsigned int count);
+void transformPoints(const mat4 &m, const vec3 *in, vec3 *out,
+                     unsigned int count);
+void transformPoints(const mat4 &m, const vec3 *in, vec3 *out, float *w,
+                     unsigned int count);
+void transformVectors(const mat4 &m, const Vec3SoA &in, const Vec3SoA &out,
+                      unsigned int count);
+void transformPoints(const mat4 &m, const Vec3SoA &in, const Vec3SoA &out,
+                     unsigned int count);
+void transformPoints(const mat4 &m, const Vec3SoA &in, const Vec3SoA &out,
+                     float *w, unsigned int count);
+// The same spread over parallelFor. grain is the number of items per task;
+// 0 picks a default.
+void transformVectorsParallel(const mat4 &m, const vec3 *in, vec3 *out,
+                              unsigned int count, unsigned int grain = 0);
+void transformPointsParallel(const mat4 &m, const vec3 *in, vec3 *out,
+                             unsigned int count, unsigned int grain = 0);
+void transformPointsParallel(const mat4 &m, const Vec3SoA &in,
+                             const Vec3SoA &out, unsigned int count,
+                             unsigned int grain = 0);
+
 void transpose(mat4 &m);
-mat4 transposed(const mat4 &m);
 float determinant(const mat4 &m);
 mat4 adjugate(const mat4 &m);
+// Singular matrices invert to the identity. The try variants return false
+// instead and leave out unchanged; out may alias m.
 mat4 inverse(const mat4 &m);
 void invert(mat4 &m);
-mat4 frustrum(float l, float r, float b, float t, float n, float f);
+bool tryInverse(const mat4 &m, mat4 &out);
+
+// Rigid: the upper 3x3 is orthonormal (rotation only). Affine: the bottom row
+// is (0, 0, 0, 1). Anything else goes through the full inverse.
+enum class Mat4Class { General, Affine, Rigid };
+Mat4Class classify(const mat4 &m);
+mat4 inverseAffine(const mat4 &m);
+bool tryInverseAffine(const mat4 &m, mat4 &out);
+mat4 inverseRigid(const mat4 &m);
+// Classifies m and takes the cheapest valid inverse.
+mat4 inverseAuto(const mat4 &m);
+
+// Batch inverses. Singular matrices are written as identity instead of being
+// reported; the return value is how many there were.
+unsigned int inverse(const mat4 *in, mat4 *out, unsigned int count);
+unsigned int inverseAffine(const mat4 *in, mat4 *out, unsigned int count);
+void inverseRigid(const mat4 *in, mat4 *out, unsigned int count);
+unsigned int inverseAuto(const mat4 *in, mat4 *out, unsigned int count);
 mat4 perspective(float fov, float aspect, float n, float f);
-mat4 ortho(float l, float r, float b, float t, float n, float f);
 mat4 lookAt(const vec3 &position, const vec3 &target, const vec3 &up);
 std::ostream &operator<<(std::ostream &stream, const mat4 &m);
+
+#ifdef MATHS_HEADER_ONLY
+#include "mat4.inl"
+#endif
@@ -0,0 +1,216 @@
+#pragma once
+#include <math.h>
+
+MATHS_INLINE bool operator==(const mat4 &a, const mat4 &b) {
+  for (int i = 0; i < 16; ++i) {
+    if (fabsf(a.v[i] - b.v[i]) > MAT4_EPSILON) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+MATHS_INLINE bool operator!=(const mat4 &a, const mat4 &b) { return !(a == b); }
+#define M4SWAP(x, y)                                                           \
+  {                                                                            \
+    float t = x;                                                               \
+    x = y;                                                                     \
+    y = t;                                                                     \
+  }
+
+#define M4_3X3MINOR(c0, c1, c2, r0, r1, r2)                                    \
+  (m.v[c0 * 4 + r0] * (m.v[c1 * 4 + r1] * m.v[c2 * 4 + r2] -                   \
+                       m.v[c1 * 4 + r2] * m.v[c2 * 4 + r1]) -                  \
+   m.v[c1 * 4 + r0] * (m.v[c0 * 4 + r1] * m.v[c2 * 4 + r2] -                   \
+                       m.v[c0 * 4 + r2] * m.v[c2 * 4 + r1]) +                  \
+   m.v[c2 * 4 + r0] * (m.v[c0 * 4 + r1] * m.v[c1 * 4 + r2] -                   \
+                       m.v[c0 * 4 + r2] * m.v[c1 * 4 + r1]))
+
+MATHS_INLINE void transpose(mat4 &m) {
+
+  M4SWAP(m.xy, m.yx);
+  M4SWAP(m.xz, m.zx);
+  M4SWAP(m.xw, m.tx);
+  M4SWAP(m.zy, m.yz);
+  M4SWAP(m.ty, m.yw);
+  M4SWAP(m.tz, m.zw);
+}
+
+MATHS_INLINE float determinant(const mat4 &m) {
+  return m.v[0] * M4_3X3MINOR(1, 2, 3, 1, 2, 3) -
+         m.v[4] * M4_3X3MINOR(0, 2, 3, 1, 2, 3) +
+         m.v[8] * M4_3X3MINOR(0, 1, 3, 1, 2, 3) -
+         m.v[12] * M4_3X3MINOR(0, 1, 2, 1, 2, 3);
+}
+
+MATHS_INLINE mat4 adjugate(const mat4 &m) {
+  // Cofactor(M[i, j]) = Minor(M[i, j]] * pow(-1, i + j)
+  mat4 cofactor;
+
+  cofactor.v[0] = M4_3X3MINOR(1, 2, 3, 1, 2, 3);
+  cofactor.v[1] = -M4_3X3MINOR(1, 2, 3, 0, 2, 3);
+  cofactor.v[2] = M4_3X3MINOR(1, 2, 3, 0, 1, 3);
+  cofactor.v[3] = -M4_3X3MINOR(1, 2, 3, 0, 1, 2);
+
+  cofactor.v[4] = -M4_3X3MINOR(0, 2, 3, 1, 2, 3);
+  cofactor.v[5] = M4_3X3MINOR(0, 2, 3, 0, 2, 3);
+  cofactor.v[6] = -M4_3X3MINOR(0, 2, 3, 0, 1, 3);
+  cofactor.v[7] = M4_3X3MINOR(0, 2, 3, 0, 1, 2);
+
+  cofactor.v[8] = M4_3X3MINOR(0, 1, 3, 1, 2, 3);
+  cofactor.v[9] = -M4_3X3MINOR(0, 1, 3, 0, 2, 3);
+  cofactor.v[10] = M4_3X3MINOR(0, 1, 3, 0, 1, 3);
+  cofactor.v[11] = -M4_3X3MINOR(0, 1, 3, 0, 1, 2);
+
+  cofactor.v[12] = -M4_3X3MINOR(0, 1, 2, 1, 2, 3);
+  cofactor.v[13] = M4_3X3MINOR(0, 1, 2, 0, 2, 3);
+  cofactor.v[14] = -M4_3X3MINOR(0, 1, 2, 0, 1, 3);
+  cofactor.v[15] = M4_3X3MINOR(0, 1, 2, 0, 1, 2);
+
+  return transposed(cofactor);
+}
+
+// Out-of-line builds route tryInverse through the SIMD kernels selected at
+// load time (src/mat4Kernels.cpp).
+#ifdef MATHS_HEADER_ONLY
+MATHS_INLINE bool tryInverse(const mat4 &m, mat4 &out) {
+  float det = determinant(m);
+  if (det == 0.0f) {
+    MATHS_COUNT(Diagnostic::SingularInverse);
+    return false;
+  }
+  out = adjugate(m) * (1 / det);
+  return true;
+}
+#endif
+
+MATHS_INLINE mat4 inverse(const mat4 &m) {
+  mat4 result;
+  if (!tryInverse(m, result)) {
+    return mat4();
+  }
+  return result;
+}
+
+MATHS_INLINE void invert(mat4 &m) {
+  if (!tryInverse(m, m)) {
+    m = mat4();
+  }
+}
+
+MATHS_INLINE Mat4Class classify(const mat4 &m) {
+  if (m.xw != 0.0f || m.yw != 0.0f || m.zw != 0.0f || m.tw != 1.0f) {
+    return Mat4Class::General;
+  }
+  vec3 x(m.xx, m.xy, m.xz);
+  vec3 y(m.yx, m.yy, m.yz);
+  vec3 z(m.zx, m.zy, m.zz);
+  if (fabsf(dot(x, x) - 1.0f) > MAT4_EPSILON ||
+      fabsf(dot(y, y) - 1.0f) > MAT4_EPSILON ||
+      fabsf(dot(z, z) - 1.0f) > MAT4_EPSILON ||
+      fabsf(dot(x, y)) > MAT4_EPSILON || fabsf(dot(x, z)) > MAT4_EPSILON ||
+      fabsf(dot(y, z)) > MAT4_EPSILON) {
+    return Mat4Class::Affine;
+  }
+  return Mat4Class::Rigid;
+}
+
+MATHS_INLINE bool tryInverseAffine(const mat4 &m, mat4 &out) {
+  vec3 x(m.xx, m.xy, m.xz);
+  vec3 y(m.yx, m.yy, m.yz);
+  vec3 z(m.zx, m.zy, m.zz);
+  // Rows of the inverse 3x3 are the cross products of the column pairs
+  vec3 r0 = cross(y, z);
+  vec3 r1 = cross(z, x);
+  vec3 r2 = cross(x, y);
+  float det = dot(x, r0);
+  if (det == 0.0f) {
+    MATHS_COUNT(Diagnostic::SingularInverseAffine);
+    return false;
+  }
+  float invDet = 1.0f / det;
+  r0 = r0 * invDet;
+  r1 = r1 * invDet;
+  r2 = r2 * invDet;
+  vec3 t(m.tx, m.ty, m.tz);
+  out = mat4(r0.x, r1.x, r2.x, 0, //
+             r0.y, r1.y, r2.y, 0, //
+             r0.z, r1.z, r2.z, 0, //
+             -dot(r0, t), -dot(r1, t), -dot(r2, t), 1);
+  return true;
+}
+
+MATHS_INLINE mat4 inverseAffine(const mat4 &m) {
+  mat4 result;
+  if (!tryInverseAffine(m, result)) {
+    return mat4();
+  }
+  return result;
+}
+
+MATHS_INLINE mat4 inverseRigid(const mat4 &m) {
+  vec3 x(m.xx, m.xy, m.xz);
+  vec3 y(m.yx, m.yy, m.yz);
+  vec3 z(m.zx, m.zy, m.zz);
+  vec3 t(m.tx, m.ty, m.tz);
+  return mat4(m.xx, m.yx, m.zx, 0, //
+              m.xy, m.yy, m.zy, 0, //
+              m.xz, m.yz, m.zz, 0, //
+              -dot(x, t), -dot(y, t), -dot(z, t), 1);
+}
+
+MATHS_INLINE mat4 inverseAuto(const mat4 &m) {
+  switch (classify(m)) {
+  case Mat4Class::Rigid:
+    return inverseRigid(m);
+  case Mat4Class::Affine:
+    return inverseAffine(m);
+  default:
+    return inverse(m);
+  }
+}
+
+MATHS_INLINE mat4 perspective(float fov, float aspect, float znear,
+                              float zfar) {
+  float ymax = znear * tanf(fov * 3.14159265359f / 360.0f);
+  float xmax = ymax * aspect;
+
+  return frustum(-xmax, xmax, -ymax, ymax, znear, zfar);
+}
+
+MATHS_INLINE mat4 lookAt(const vec3 &position, const vec3 &target,
+                         const vec3 &up) {
+  // Remember, forward is negative z
+  vec3 f = normalized(target - position) * -1.0f;
+  vec3 r = cross(up, f); // Right handed
+  if (r == vec3(0, 0, 0)) {
+    MATHS_COUNT(Diagnostic::DegenerateLookAt);
+    return mat4();
+  }
+  normalize(r);
+  vec3 u = normalized(cross(f, r)); // Right handed
+
+  vec3 t = vec3(0.0f - dot(r, position), 0.0f - dot(u, position),
+                0.0f - dot(f, position));
+
+  return mat4(
+      // Transpose upper 3x3 matrix to invert it
+      r.x, u.x, f.x, 0, r.y, u.y, f.y, 0, r.z, u.z, f.z, 0, t.x, t.y, t.z, 1);
+}
+
+MATHS_INLINE std::ostream &operator<<(std::ostream &stream, const mat4 &m) {
+
+  stream << m.vec.right.x << " " << m.vec.up.x << " " << m.vec.forward.x
+         << " " << m.vec.position.x << "\n";
+  stream << m.vec.right.y << " " << m.vec.up.y << " " << m.vec.forward.y
+         << " " << m.vec.position.y << "\n";
+  stream << m.vec.right.z << " " << m.vec.up.z << " " << m.vec.forward.z
+         << " " << m.vec.position.z << "\n";
+  stream << m.vec.right.w << " " << m.vec.up.w << " " << m.vec.forward.w
+         << " " << m.vec.position.w << "\n";
+  return stream;
+}
+
+#undef M4SWAP
+#undef M4_3X3MINOR
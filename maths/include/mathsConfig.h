@@ -0,0 +1,24 @@
+#pragma once
+
+// MATHS_HEADER_ONLY pulls the operator definitions (*.inl) into every
+// translation unit that includes the headers so they can be inlined at the
+// call site. It is set by the MATHS_HEADER_ONLY CMake option.
+#ifdef MATHS_HEADER_ONLY
+#define MATHS_INLINE inline
+#else
+#define MATHS_INLINE
+#endif
+
+// MATHS_CONSTANT_EVALUATED() is true while a constexpr function is being
+// folded at compile time, so its runtime path can still call the SIMD
+// kernels. Without the builtin the portable constexpr path is used always.
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define MATHS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#endif
+#if !defined(MATHS_CONSTANT_EVALUATED) &&                                      \
+    ((defined(__GNUC__) && __GNUC__ >= 9) ||                                   \
+     (defined(_MSC_VER) && _MSC_VER >= 1925))
+#define MATHS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
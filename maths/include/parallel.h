@@ -0,0 +1,39 @@
+#pragma once
+
+typedef void (*ParallelTask)(void *context, unsigned int begin,
+                             unsigned int end);
+
+// Splits [0, count) into ranges of at most grain items and runs task on them
+// across a fixed pool of worker threads and the calling one. Each thread
+// starts on its own share and steals half of another's when it runs out.
+// Returns once every range is done. Nothing is allocated per call.
+// A call made from inside a task, or while another thread is using the
+// pool, runs its ranges on the calling thread instead.
+void parallelFor(unsigned int count, unsigned int grain, ParallelTask task,
+                 void *context);
+// Threads parallelFor runs on, including the caller.
+unsigned int parallelThreadCount();
+// Resizes the pool; 0 goes back to one thread per hardware thread. Must not
+// be called while a parallelFor is running.
+void setParallelThreadCount(unsigned int count);
+
+// Routes parallelFor to another task system. run must call task on ranges
+// that cover [0, count) exactly once and return when all of them are done;
+// user is passed back unchanged. A null scheduler restores the built-in
+// pool. Must not be called while a parallelFor is running.
+struct ParallelScheduler {
+  void (*run)(void *user, unsigned int count, unsigned int grain,
+              ParallelTask task, void *context);
+  void *user;
+};
+void setParallelScheduler(const ParallelScheduler *scheduler);
+
+template <typename F>
+void parallelFor(unsigned int count, unsigned int grain, const F &fn) {
+  parallelFor(
+      count, grain,
+      [](void *context, unsigned int begin, unsigned int end) {
+        (*(const F *)context)(begin, end);
+      },
+      (void *)&fn);
+}
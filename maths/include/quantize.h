@@ -0,0 +1,86 @@
+#pragma once
+#include "transform.h"
+
+// Compact storage for rotations, positions and whole Transforms. Everything
+// is reconstructed into the regular float types before use.
+
+// Smallest three: the largest component of the unit quaternion is dropped
+// (q and -q are the same rotation, so it is made positive and rebuilt from
+// the other three) and the remaining three, which lie in
+// [-1/sqrt(2), 1/sqrt(2)], are stored in fixed point with a 2-bit index of
+// the dropped one. Inputs are normalized first; a zero quaternion packs as
+// the identity.
+// 48 bits: 15 bits per component, under 1.5e-4 radians of error.
+struct PackedQuat48 {
+  unsigned short bits[3];
+};
+// 32 bits: 10 bits per component, under 5e-3 radians of error.
+struct PackedQuat32 {
+  unsigned short bits[2];
+};
+
+PackedQuat48 packQuat48(const quat &q);
+quat unpackQuat48(const PackedQuat48 &p);
+PackedQuat32 packQuat32(const quat &q);
+quat unpackQuat32(const PackedQuat32 &p);
+
+// IEEE 754 binary16, rounded to nearest even. The relative error is 2^-11;
+// magnitudes from 65520 on become infinity.
+unsigned short floatToHalf(float f);
+float halfToFloat(unsigned short h);
+
+struct PackedVec3 {
+  unsigned short x, y, z;
+};
+
+// Fixed point inside an axis-aligned box, 16 bits per axis. Positions are
+// clamped to the box; inside it the error is (max - min) / 131070 per axis
+// plus float rounding.
+struct PositionRange {
+  vec3 min;
+  vec3 max;
+};
+// The bounds of the positions of count Transforms.
+PositionRange positionRange(const Transform *t, unsigned int count);
+
+PackedVec3 packPosition(const vec3 &p, const PositionRange &range);
+vec3 unpackPosition(const PackedVec3 &p, const PositionRange &range);
+PackedVec3 packHalf(const vec3 &v);
+vec3 unpackHalf(const PackedVec3 &p);
+
+// 14 bytes: fixed-point position, 48-bit rotation and a half-float uniform
+// scale. Only scale.x is stored, so non-uniform scale is not preserved.
+struct PackedTransform {
+  PackedVec3 position;
+  PackedQuat48 rotation;
+  unsigned short scale;
+};
+
+// 10 bytes: fixed-point position and 32-bit rotation. Scale unpacks as one.
+struct PackedRigidTransform {
+  PackedVec3 position;
+  PackedQuat32 rotation;
+};
+
+PackedTransform packTransform(const Transform &t, const PositionRange &range);
+Transform unpackTransform(const PackedTransform &p,
+                          const PositionRange &range);
+PackedRigidTransform packRigidTransform(const Transform &t,
+                                        const PositionRange &range);
+Transform unpackRigidTransform(const PackedRigidTransform &p,
+                               const PositionRange &range);
+
+// Batch versions of the above.
+void packQuat48(const quat *in, PackedQuat48 *out, unsigned int count);
+void unpackQuat48(const PackedQuat48 *in, quat *out, unsigned int count);
+void packQuat32(const quat *in, PackedQuat32 *out, unsigned int count);
+void unpackQuat32(const PackedQuat32 *in, quat *out, unsigned int count);
+void packTransform(const Transform *in, const PositionRange &range,
+                   PackedTransform *out, unsigned int count);
+void unpackTransform(const PackedTransform *in, const PositionRange &range,
+                     Transform *out, unsigned int count);
+void packRigidTransform(const Transform *in, const PositionRange &range,
+                        PackedRigidTransform *out, unsigned int count);
+void unpackRigidTransform(const PackedRigidTransform *in,
+                          const PositionRange &range, Transform *out,
+                          unsigned int count);
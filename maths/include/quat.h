@@ -4,6 +4,7 @@
 
 #define QUAT_DEG2RAD 0.0174533f
 #define QUAT_RAD2DEG 57.2958f
+#define QUAT_EPSILON 0.0000001f
 
 struct quat {
   union {
@@ -19,37 +20,122 @@ struct quat {
     } data;
     float v[4];
   };
-  inline quat() : x(0), y(0), z(0), w(1) {}
-  inline quat(float _x, float _y, float _z, float _w)
+  constexpr quat() : x(0), y(0), z(0), w(1) {}
+  constexpr quat(float _x, float _y, float _z, float _w)
       : x(_x), y(_y), z(_z), w(_w) {}
 };
 
+// Structure-of-arrays view over separate x, y, z and w streams.
+struct QuatSoA {
+  float *x;
+  float *y;
+  float *z;
+  float *w;
+};
+
 quat angleAxis(float angle, const vec3 &axis);
 
 quat fromTo(const vec3 &from, const vec3 &to);
 vec3 getAxis(const quat &quat);
 float getAngle(const quat &quat);
-quat operator+(const quat &a, const quat &b);
-quat operator*(const quat &a, const quat &b);
-vec3 operator*(const quat &q, const vec3 &v);
-quat operator*(const quat &q, float b);
-quat operator-(const quat &a, const quat &b);
+
+// constexpr arithmetic, defined here in every build mode. Only x, y, z and w
+// are read because the other union members are not active in a constant
+// expression.
+constexpr quat operator+(const quat &a, const quat &b) {
+  return quat(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w);
+}
+
+constexpr quat operator-(const quat &a, const quat &b) {
+  return quat(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w);
+}
+
+constexpr quat operator-(const quat &q) { return quat(-q.x, -q.y, -q.z, -q.w); }
+
+constexpr quat operator*(const quat &a, float b) {
+  return quat(a.x * b, a.y * b, a.z * b, a.w * b);
+}
+
+constexpr quat operator*(const quat &Q1, const quat &Q2) {
+  return quat(                                                //
+      Q2.x * Q1.w + Q2.y * Q1.z - Q2.z * Q1.y + Q2.w * Q1.x,  //
+      -Q2.x * Q1.z + Q2.y * Q1.w + Q2.z * Q1.x + Q2.w * Q1.y, //
+      Q2.x * Q1.y - Q2.y * Q1.x + Q2.z * Q1.w + Q2.w * Q1.z,  //
+      -Q2.x * Q1.x - Q2.y * Q1.y - Q2.z * Q1.z + Q2.w * Q1.w  //
+  );
+}
+
+constexpr vec3 operator*(const quat &q, const vec3 &v) {
+  vec3 u(q.x, q.y, q.z);
+  return u * 2.0f * dot(u, v) + v * (q.w * q.w - dot(u, u)) +
+         cross(u, v) * 2.0f * q.w;
+}
+
+constexpr float dot(const quat &a, const quat &b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+constexpr float lenSq(const quat &l) {
+  return l.x * l.x + l.y * l.y + l.z * l.z + l.w * l.w;
+}
+
+constexpr quat conjugate(const quat &q) { return quat(-q.x, -q.y, -q.z, q.w); }
+
+constexpr quat inverse(const quat &q) {
+  float lenSqu = lenSq(q);
+  if (lenSqu < QUAT_EPSILON) {
+    return quat();
+  }
+  float recip = 1.0f / lenSqu;
+  return quat(-q.x * recip, -q.y * recip, -q.z * recip, q.w * recip);
+}
+
+constexpr quat mix(const quat &from, const quat &to, float t) {
+  return from * (1.0f - t) + to * t;
+}
+
+// q * (1, 0, 0), q * (0, 1, 0) and q * (0, 0, 1) expanded by hand
+constexpr mat4 quatToMat4(const quat &q) {
+  float k = q.w * q.w - q.x * q.x - q.y * q.y - q.z * q.z;
+  float x2 = q.x * 2.0f, y2 = q.y * 2.0f, z2 = q.z * 2.0f;
+  float xx = q.x * x2, yy = q.y * y2, zz = q.z * z2;
+  float xy = q.x * y2, xz = q.x * z2, yz = q.y * z2;
+  float wx = q.w * x2, wy = q.w * y2, wz = q.w * z2;
+  return mat4(                     //
+      xx + k, xy + wz, xz - wy, 0, //
+      xy - wz, yy + k, yz + wx, 0, //
+      xz + wy, yz - wx, zz + k, 0, //
+      0, 0, 0, 1);
+}
+
 bool operator==(const quat &left, const quat &right);
 bool operator!=(const quat &left, const quat &right);
-quat operator-(const quat &q);
-quat operator*(const quat &a, float b);
 quat operator^(const quat &a, float b);
 bool sameOrientation(const quat &l, const quat &r);
-float dot(const quat &a, const quat &b);
-float lenSq(const quat &v);
 float len(const quat &v);
 void normalize(quat &v);
 quat normalized(const quat &v);
-quat conjugate(const quat &q);
-quat inverse(const quat &q);
-quat mix(const quat &from, const quat &to, float f);
 quat nlerp(const quat &from, const quat &to, float f);
 quat slerp(const quat &from, const quat &to, float f);
+// Slerp along the shorter arc using only multiplies and adds (Eberly's
+// series for sin(t * a) / sin(a), cut after twelve terms). For unit inputs
+// every component is within 2e-6 of an exact slerp, and much closer when the
+// inputs are near each other, so no normalize is needed.
+// Unlike slerp, which follows the 4D arc, a negative dot flips `to`.
+quat fastSlerp(const quat &from, const quat &to, float t);
+void fastSlerp(const quat *from, const quat *to, float t, quat *out,
+               unsigned int count);
+void fastSlerp(const quat *from, const quat *to, const float *t, quat *out,
+               unsigned int count);
 quat lookRotation(const vec3 &direction, const vec3 &up);
-mat4 quatToMat4(const quat &q);
 quat mat4ToQuat(const mat4 &m);
+void quatToMat4(const quat *in, mat4 *out, unsigned int count);
+void mat4ToQuat(const mat4 *in, quat *out, unsigned int count);
+// Normalizes in place; near-zero quaternions are left alone like
+// normalize(quat &). grain 0 picks a default.
+void normalize(quat *q, unsigned int count);
+void normalizeParallel(quat *q, unsigned int count, unsigned int grain = 0);
+
+#ifdef MATHS_HEADER_ONLY
+#include "quat.inl"
+#endif
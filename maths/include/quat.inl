@@ -0,0 +1,183 @@
+#pragma once
+#include <math.h>
+
+MATHS_INLINE quat angleAxis(float angle, const vec3 &axis) {
+  vec3 norm = normalized(axis);
+
+  float s = sinf(angle * 0.5f);
+  return quat(norm.x * s, norm.y * s, norm.z * s, cosf(angle * 0.5f));
+}
+
+MATHS_INLINE quat fromTo(const vec3 &from, const vec3 &to) {
+  vec3 f = normalized(from);
+  vec3 t = normalized(to);
+  if (f == t) {
+    return quat();
+  } else if (f == t * -1.0f) {
+    vec3 ortho = vec3(1, 0, 0);
+    if (fabsf(f.y) < fabsf(f.x)) {
+      ortho = vec3(0, 1, 0);
+    }
+    if (fabsf(f.z) < fabs(f.y) && fabs(f.z) < fabsf(f.x)) {
+      ortho = vec3(0, 0, 1);
+    }
+    vec3 axis = normalized(cross(f, ortho));
+    return quat(axis.x, axis.y, axis.z, 0);
+  }
+  vec3 half = normalized(f + t);
+  vec3 axis = cross(f, half);
+  return quat(axis.x, axis.y, axis.z, dot(f, half));
+}
+
+MATHS_INLINE vec3 getAxis(const quat &quat) {
+  return normalized(vec3(quat.x, quat.y, quat.z));
+}
+
+MATHS_INLINE float getAngle(const quat &quat) { return 2.0f * acosf(quat.w); }
+
+MATHS_INLINE quat operator+(const quat &a, float b) {
+  return quat(a.x * b, a.y * b, a.z * b, a.w * b);
+}
+
+MATHS_INLINE bool operator==(const quat &left, const quat &right) {
+  return (fabsf(left.x - right.x) <= QUAT_EPSILON &&
+          fabsf(left.y - right.y) <= QUAT_EPSILON &&
+          fabsf(left.z - right.z) <= QUAT_EPSILON &&
+          fabsf(left.w - right.w) <= QUAT_EPSILON);
+}
+MATHS_INLINE bool operator!=(const quat &a, const quat &b) { return !(a == b); }
+MATHS_INLINE bool sameOrientation(const quat &left, const quat &right) {
+  return (fabsf(left.x - right.x) <= QUAT_EPSILON &&
+          fabsf(left.y - right.y) <= QUAT_EPSILON &&
+          fabsf(left.z - right.z) <= QUAT_EPSILON &&
+          fabsf(left.w - right.w) <= QUAT_EPSILON) ||
+         (fabsf(left.x + right.x) <= QUAT_EPSILON &&
+          fabsf(left.y + right.y) <= QUAT_EPSILON &&
+          fabsf(left.z + right.z) <= QUAT_EPSILON &&
+          fabsf(left.w + right.w) <= QUAT_EPSILON);
+}
+
+MATHS_INLINE float len(const quat &l) {
+  float lenSqu = lenSq(l);
+  if (lenSqu < QUAT_EPSILON) {
+    return 0.0f;
+  }
+  return sqrtf(lenSqu);
+}
+
+MATHS_INLINE void normalize(quat &v) {
+  if (lenSq(v) < QUAT_EPSILON) {
+    return;
+  }
+  float invLen = 1.0f / sqrtf(lenSq(v));
+  v.x *= invLen;
+  v.y *= invLen;
+  v.z *= invLen;
+  v.w *= invLen;
+}
+
+MATHS_INLINE quat normalized(const quat &v) {
+  if (lenSq(v) < QUAT_EPSILON) {
+    return quat();
+  }
+  quat res(v.x, v.y, v.z, v.w);
+  normalize(res);
+  return res;
+}
+
+MATHS_INLINE quat nlerp(const quat &from, const quat &to, float t) {
+  return normalized(from + (to - from) * t);
+}
+
+MATHS_INLINE quat slerp(const quat &start, const quat &end, float t) {
+  if (fabs(dot(start, end)) > 1.0f - QUAT_EPSILON) {
+    return nlerp(start, end, t);
+  }
+  quat delta = inverse(start) * end;
+  return normalized((delta ^ t) * start);
+}
+
+MATHS_INLINE quat fastSlerp(const quat &from, const quat &to, float t) {
+  // u[i] = 1 / (i * (2i + 1)) and v[i] = i / (2i + 1) for i = 1..12, the
+  // last pair scaled by 1.89372 to make up for the truncated series.
+  static const float u[12] = {
+      1.0f / (1 * 3),   1.0f / (2 * 5),   1.0f / (3 * 7),
+      1.0f / (4 * 9),   1.0f / (5 * 11),  1.0f / (6 * 13),
+      1.0f / (7 * 15),  1.0f / (8 * 17),  1.0f / (9 * 19),
+      1.0f / (10 * 21), 1.0f / (11 * 23), 1.89372f / (12 * 25)};
+  static const float v[12] = {1.0f / 3,   2.0f / 5,   3.0f / 7,
+                              4.0f / 9,   5.0f / 11,  6.0f / 13,
+                              7.0f / 15,  8.0f / 17,  9.0f / 19,
+                              10.0f / 21, 11.0f / 23, 1.89372f * 12 / 25};
+  float x = dot(from, to);
+  float sign = 1.0f;
+  if (x < 0.0f) {
+    x = -x;
+    sign = -1.0f;
+  }
+  float xm1 = x - 1.0f;
+  float d = 1.0f - t;
+  float tt = t * t;
+  float dd = d * d;
+  float ct = 1.0f;
+  float cd = 1.0f;
+  for (int i = 11; i >= 0; --i) {
+    ct = 1.0f + (u[i] * tt - v[i]) * xm1 * ct;
+    cd = 1.0f + (u[i] * dd - v[i]) * xm1 * cd;
+  }
+  ct *= sign * t;
+  cd *= d;
+  return quat(from.x * cd + to.x * ct, from.y * cd + to.y * ct,
+              from.z * cd + to.z * ct, from.w * cd + to.w * ct);
+}
+
+MATHS_INLINE quat operator^(const quat &q, float f) {
+  float angle = 2.0f * acosf(q.data.scalar);
+  vec3 axis = normalized(q.data.vector);
+  float halfCos = cosf(f * angle * 0.5f);
+  float halfSin = sinf(f * angle * 0.5f);
+  return quat(axis.x * halfSin, axis.y * halfSin, axis.z * halfSin, halfCos);
+}
+
+MATHS_INLINE quat lookRotation(const vec3 &direction, const vec3 &up) {
+  // Find orhtonormal basis vectors
+  vec3 f = normalized(direction); // Object forward
+  vec3 u = normalized(up);        // Desired up
+  vec3 r = cross(u, f);           // Object Right
+
+  u = cross(f, r); // Object up
+
+  // From world to object forward
+  quat worldToObject = fromTo(vec3(0, 0, 1), f);
+  // what direction is the new object up?
+  vec3 objectUp = worldToObject * vec3(0, 1, 0);
+
+  // From object to desired up
+  quat u2u = fromTo(objectUp, u);
+  // Rotate to forward direction first
+  // then twist to correct up
+  quat result = worldToObject * u2u;
+  return normalized(result);
+}
+
+// Orthonormalizes the basis from the forward and up columns, as before, then
+// reads the quaternion off the largest of the trace and the diagonal.
+MATHS_INLINE quat mat4ToQuat(const mat4 &m) {
+  vec3 f = normalized(vec3(m.vec.forward.x, m.vec.forward.y, m.vec.forward.z));
+  vec3 r = normalized(cross(vec3(m.vec.up.x, m.vec.up.y, m.vec.up.z), f));
+  vec3 u = cross(f, r);
+
+  float trace = r.x + u.y + f.z;
+  if (trace > 0.0f) {
+    float s = 0.5f / sqrtf(trace + 1.0f);
+    return quat((u.z - f.y) * s, (f.x - r.z) * s, (r.y - u.x) * s, 0.25f / s);
+  } else if (r.x > u.y && r.x > f.z) {
+    float s = 0.5f / sqrtf(1.0f + r.x - u.y - f.z);
+    return quat(0.25f / s, (u.x + r.y) * s, (f.x + r.z) * s, (u.z - f.y) * s);
+  } else if (u.y > f.z) {
+    float s = 0.5f / sqrtf(1.0f + u.y - r.x - f.z);
+    return quat((u.x + r.y) * s, 0.25f / s, (f.y + u.z) * s, (f.x - r.z) * s);
+  }
+  float s = 0.5f / sqrtf(1.0f + f.z - r.x - u.y);
+  return quat((f.x + r.z) * s, (f.y + u.z) * s, 0.25f / s, (r.y - u.x) * s);
+}
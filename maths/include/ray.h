@@ -0,0 +1,90 @@
+#pragma once
+#include "bounds.h"
+
+#define RAY_EPSILON 0.0000001f
+// RayHit::index of a ray that hit nothing
+#define RAY_NO_HIT 0xFFFFFFFFu
+
+// Points along the ray are origin + direction * t. direction need not be unit
+// length; t is then measured in multiples of it.
+struct Ray {
+  vec3 origin;
+  vec3 direction;
+};
+
+// The nearest hit: t, the barycentrics of vertices b and c for triangles
+// (zero for boxes and spheres) and the primitive index, or RAY_NO_HIT with t
+// left at the maximum distance.
+struct RayHit {
+  float t;
+  float u;
+  float v;
+  unsigned int index;
+};
+
+// Single tests, true for a hit with t below maxT. A ray starting inside a box
+// hits it at t = 0, one starting inside a sphere where it leaves. Triangles
+// are hit from both sides, but not closer than RAY_EPSILON.
+bool intersectAabb(const Ray &ray, const Aabb &box, float maxT, float &t);
+bool intersectSphere(const Ray &ray, const Sphere &sphere, float maxT,
+                     float &t);
+bool intersectTriangle(const Ray &ray, const vec3 &a, const vec3 &b,
+                       const vec3 &c, float maxT, float &t, float &u,
+                       float &v);
+
+// One ray against many primitives, four per SIMD pass. Triangle i has the
+// vertices indices[3 * i + k], or vertices[3 * i + k] when indices is null.
+// Only hits before maxT count.
+RayHit intersectAabbs(const Ray &ray, const Aabb *boxes, unsigned int count,
+                      float maxT);
+RayHit intersectSpheres(const Ray &ray, const Sphere *spheres,
+                        unsigned int count, float maxT);
+RayHit intersectTriangles(const Ray &ray, const vec3 *vertices,
+                          const unsigned int *indices,
+                          unsigned int triangleCount, float maxT);
+
+// Packets of four or eight coherent rays in structure-of-arrays form, tested
+// against every primitive together. The hits are updated in place, so a
+// packet can be run against several primitive sets in turn; start from
+// makeRayHits.
+struct RayPacket4 {
+  float originX[4], originY[4], originZ[4];
+  float directionX[4], directionY[4], directionZ[4];
+};
+
+struct RayPacket8 {
+  float originX[8], originY[8], originZ[8];
+  float directionX[8], directionY[8], directionZ[8];
+};
+
+struct RayHits4 {
+  float t[4], u[4], v[4];
+  unsigned int index[4];
+};
+
+struct RayHits8 {
+  float t[8], u[8], v[8];
+  unsigned int index[8];
+};
+
+RayPacket4 makeRayPacket4(const Ray *rays);
+RayPacket8 makeRayPacket8(const Ray *rays);
+void makeRayHits(float maxT, RayHits4 &hits);
+void makeRayHits(float maxT, RayHits8 &hits);
+RayHit getRayHit(const RayHits4 &hits, unsigned int ray);
+RayHit getRayHit(const RayHits8 &hits, unsigned int ray);
+
+void intersectAabbs(const RayPacket4 &rays, const Aabb *boxes,
+                    unsigned int count, RayHits4 &hits);
+void intersectAabbs(const RayPacket8 &rays, const Aabb *boxes,
+                    unsigned int count, RayHits8 &hits);
+void intersectSpheres(const RayPacket4 &rays, const Sphere *spheres,
+                      unsigned int count, RayHits4 &hits);
+void intersectSpheres(const RayPacket8 &rays, const Sphere *spheres,
+                      unsigned int count, RayHits8 &hits);
+void intersectTriangles(const RayPacket4 &rays, const vec3 *vertices,
+                        const unsigned int *indices,
+                        unsigned int triangleCount, RayHits4 &hits);
+void intersectTriangles(const RayPacket8 &rays, const vec3 *vertices,
+                        const unsigned int *indices,
+                        unsigned int triangleCount, RayHits8 &hits);
@@ -0,0 +1,42 @@
+#pragma once
+#include "transform.h"
+#include <vector>
+
+// Local transforms of a scene hierarchy with cached world matrices. Nodes are
+// stored parent first, as for computeWorldMatrices, and only the subtrees
+// below nodes whose local transform was set since the last update are
+// recomputed. Edit through the functions below so the dirty state is kept.
+struct SceneTransforms {
+  std::vector<Transform> local;
+  std::vector<int> parents;
+  // World poses; the matrix is transformToMat4 of the transform
+  std::vector<Transform> worldTransforms;
+  std::vector<mat4> world;
+  // Filled in by getInverseWorldMatrix and kept until the world changes
+  std::vector<mat4> inverseWorld;
+  std::vector<int> firstChild;
+  std::vector<int> nextSibling;
+  // Nodes below and including each node
+  std::vector<unsigned int> subtreeSize;
+  std::vector<unsigned char> flags;
+  // Nodes set since the last update
+  std::vector<unsigned int> dirty;
+  // Nodes whose world matrix changed in the last update, parents first
+  std::vector<unsigned int> changed;
+};
+
+// Replaces the contents with count nodes; parents[i] is below i or negative
+// for a root. Every node starts dirty.
+void initSceneTransforms(SceneTransforms &scene, const Transform *local,
+                         const int *parents, unsigned int count);
+// Appends a dirty node under parent (negative for a root) and returns it.
+unsigned int addSceneNode(SceneTransforms &scene, int parent,
+                          const Transform &local);
+void setLocalTransform(SceneTransforms &scene, unsigned int node,
+                       const Transform &local);
+
+// Recomputes the world matrices of the dirty nodes and their descendants,
+// and lists them in scene.changed.
+void updateSceneTransforms(SceneTransforms &scene);
+// The inverse of the world matrix, computed on first use after a change.
+const mat4 &getInverseWorldMatrix(SceneTransforms &scene, unsigned int node);
@@ -0,0 +1,31 @@
+#pragma once
+#include "dualQuaternion.h"
+#include "vec4.h"
+
+// Dual quaternion linear blend skinning. Each vertex has four joint indices
+// into palette and four weights, which should sum to one. Influences whose
+// real part points into the other hemisphere than the first one are negated
+// before blending. normals and outNormals may be null to skip normals;
+// outputs may alias the inputs.
+void skinDualQuaternion(const DualQuaternion *palette, const ivec4 *joints,
+                        const vec4 *weights, const vec3 *positions,
+                        const vec3 *normals, vec3 *outPositions,
+                        vec3 *outNormals, unsigned int vertexCount);
+void skinDualQuaternionParallel(const DualQuaternion *palette,
+                                const ivec4 *joints, const vec4 *weights,
+                                const vec3 *positions, const vec3 *normals,
+                                vec3 *outPositions, vec3 *outNormals,
+                                unsigned int vertexCount);
+
+// Skinning palettes: joint i gets world[i] * inverseBindPose[i]. The matrix
+// versions write the top three rows of each product row-major, twelve floats
+// per joint, which is the float3x4 layout shaders expect. The dual quaternion
+// version feeds skinDualQuaternion and drops scale. Large palettes written to
+// 16-byte aligned buffers bypass the cache with non-temporal stores.
+void buildSkinningPalette(const Transform *world, const mat4 *inverseBindPose,
+                          float *out, unsigned int jointCount);
+void buildSkinningPalette(const mat4 *world, const mat4 *inverseBindPose,
+                          float *out, unsigned int jointCount);
+void buildSkinningPalette(const Transform *world,
+                          const Transform *inverseBindPose,
+                          DualQuaternion *out, unsigned int jointCount);
@@ -0,0 +1,36 @@
+#pragma once
+#include "transform.h"
+#include <stddef.h>
+
+// Text form of vec3, quat, mat4 and Transform arrays: one element per line,
+// its floats separated by single spaces, each in the shortest form that reads
+// back to the same value. mat4 is written as v[0] to v[15]; Transform as the
+// position, rotation and scale floats in that order.
+//
+// A float and its separator never take more than TEXT_FLOAT_MAX_CHARS, so
+// count * floats per element * TEXT_FLOAT_MAX_CHARS is always enough room.
+#define TEXT_FLOAT_MAX_CHARS 16
+
+// Write count elements into out and return the number of characters written,
+// or 0 when they do not fit in capacity. Nothing is null terminated.
+size_t formatText(const vec3 *in, char *out, size_t capacity,
+                  unsigned int count);
+size_t formatText(const quat *in, char *out, size_t capacity,
+                  unsigned int count);
+size_t formatText(const mat4 *in, char *out, size_t capacity,
+                  unsigned int count);
+size_t formatText(const Transform *in, char *out, size_t capacity,
+                  unsigned int count);
+
+// Read up to count elements from text. Floats may be separated by any
+// whitespace, so line breaks are not required between elements. Returns the
+// number of whole elements read; reading stops at the first token that is
+// not a float.
+unsigned int parseText(const char *text, size_t length, vec3 *out,
+                       unsigned int count);
+unsigned int parseText(const char *text, size_t length, quat *out,
+                       unsigned int count);
+unsigned int parseText(const char *text, size_t length, mat4 *out,
+                       unsigned int count);
+unsigned int parseText(const char *text, size_t length, Transform *out,
+                       unsigned int count);
@@ -9,17 +9,40 @@ struct Transform {
 
   vec3 scale;
 
-  Transform(const vec3 &p, const quat &r, const vec3 &s)
+  constexpr Transform(const vec3 &p, const quat &r, const vec3 &s)
       : position(p), rotation(r), scale(s) {}
-  Transform()
+  constexpr Transform()
       : position(vec3(0, 0, 0)), rotation(quat()), scale(vec3(1, 1, 1)) {}
 };
 
-Transform combine(const Transform &a, const Transform &b);
+constexpr Transform combine(const Transform &a, const Transform &b) {
+  return Transform(a.position + a.rotation * (a.scale * b.position),
+                   b.rotation * a.rotation, a.scale * b.scale);
+}
+
+constexpr vec3 transformVector(const Transform &a, const vec3 &b) {
+  return a.rotation * (a.scale * b);
+}
+
+constexpr vec3 transformPoint(const Transform &a, const vec3 &b) {
+  return a.position + a.rotation * (a.scale * b);
+}
+
 Transform mix(const Transform &a, const Transform &b, float t);
 Transform inverse(const Transform &t);
+// Assumes a unit rotation and unit scale: conjugates instead of dividing.
+Transform inverseRigid(const Transform &t);
+void inverse(const Transform *in, Transform *out, unsigned int count);
+void inverseRigid(const Transform *in, Transform *out, unsigned int count);
 mat4 transformToMat4(const Transform &t);
 Transform toTransform(const mat4 &t);
-vec3 transformPoint(const Transform &a, const vec3 &b);
-vec3 transformVector(const Transform &a, const vec3 &b);
+void transformToMat4(const Transform *in, mat4 *out, unsigned int count);
+void toTransform(const mat4 *in, Transform *out, unsigned int count);
+// transformToMat4 over parallelFor; grain 0 picks a default.
+void transformToMat4Parallel(const Transform *in, mat4 *out,
+                             unsigned int count, unsigned int grain = 0);
 std::ostream &operator<<(std::ostream &stream, const Transform &m);
+
+#ifdef MATHS_HEADER_ONLY
+#include "transform.inl"
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+#include <math.h>
+
+MATHS_INLINE Transform inverse(const Transform &t) {
+  Transform inv;
+  inv.rotation = inverse(t.rotation);
+  inv.scale.x = fabs(t.scale.x) < VEC3_EPSILON ? 0.0f : 1.0f / t.scale.x;
+  inv.scale.y = fabs(t.scale.y) < VEC3_EPSILON ? 0.0f : 1.0f / t.scale.y;
+  inv.scale.z = fabs(t.scale.z) < VEC3_EPSILON ? 0.0f : 1.0f / t.scale.z;
+  vec3 invTrans = t.position * -1.0f;
+  inv.position = inv.rotation * (inv.scale * invTrans);
+  return inv;
+}
+
+MATHS_INLINE Transform inverseRigid(const Transform &t) {
+  Transform inv;
+  inv.rotation = conjugate(t.rotation);
+  inv.position = inv.rotation * (t.position * -1.0f);
+  return inv;
+}
+
+MATHS_INLINE Transform mix(const Transform &a, const Transform &b, float t) {
+  quat bRot = b.rotation;
+  if (dot(a.rotation, bRot) < 0.0f) {
+    bRot = -bRot;
+  }
+  return Transform(lerp(a.position, b.position, t), //
+                   nlerp(a.rotation, bRot, t),      //
+                   lerp(a.scale, b.scale, t));
+}
+
+MATHS_INLINE mat4 transformToMat4(const Transform &t) {
+  mat4 m = quatToMat4(t.rotation);
+  for (int i = 0; i < 3; ++i) {
+    m.v[i] *= t.scale.x;
+    m.v[4 + i] *= t.scale.y;
+    m.v[8 + i] *= t.scale.z;
+  }
+  m.v[12] = t.position.x;
+  m.v[13] = t.position.y;
+  m.v[14] = t.position.z;
+  return m;
+}
+
+MATHS_INLINE Transform toTransform(const mat4 &m) {
+  Transform out;
+  out.position = vec3(m.v[12], m.v[13], m.v[14]);
+  out.rotation = mat4ToQuat(m);
+  // Diagonal of the upper 3x3 times quatToMat4(inverse(rotation)), which is
+  // the dot of each row with the matching row of the rotation matrix.
+  mat4 r = quatToMat4(out.rotation);
+  out.scale = vec3(m.v[0] * r.v[0] + m.v[4] * r.v[4] + m.v[8] * r.v[8],
+                   m.v[1] * r.v[1] + m.v[5] * r.v[5] + m.v[9] * r.v[9],
+                   m.v[2] * r.v[2] + m.v[6] * r.v[6] + m.v[10] * r.v[10]);
+  return out;
+}
+
+MATHS_INLINE std::ostream &operator<<(std::ostream &stream,
+                                      const Transform &m) {
+  stream << "Position: (" << m.position.x << ", " << m.position.y << ", "
+         << m.position.z << ") Rotation: (" << m.rotation.x << ", "
+         << m.rotation.y << ", " << m.rotation.z << ", " << m.rotation.w
+         << ") Scale: (" << m.scale.x << ", " << m.scale.y << ", " << m.scale.z
+         << ")";
+  return stream;
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include "mathsConfig.h"
 #define VEC3_EPSILON 0.0000001f
 #include <ostream>
 template <typename T> struct Tvec3 {
@@ -10,32 +11,79 @@ template <typename T> struct Tvec3 {
     };
     T v[3];
   };
-  inline Tvec3() : x(0.0f), y(0.0f), z(0.0f) {}
-  inline Tvec3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
-  inline Tvec3(float *fv) : x(fv[0]), y(fv[1]), z(fv[2]) {}
+  constexpr Tvec3() : x(0.0f), y(0.0f), z(0.0f) {}
+  constexpr Tvec3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+  constexpr Tvec3(float *fv) : x(fv[0]), y(fv[1]), z(fv[2]) {}
 };
 typedef Tvec3<int> ivec3;
 typedef Tvec3<float> vec3;
 typedef Tvec3<unsigned int> uivec3;
-vec3 operator+(const vec3 &l, const vec3 &r);
-vec3 operator-(const vec3 &l, const vec3 &r);
-vec3 operator*(const vec3 &l, float f);
-vec3 operator*(const vec3 &l, const vec3 &r);
-float dot(const vec3 &l, const vec3 &r);
-float lenSq(const vec3 &v);
+
+// Structure-of-arrays view over separate x, y and z streams.
+struct Vec3SoA {
+  float *x;
+  float *y;
+  float *z;
+};
+
+// The arithmetic below is constexpr and therefore defined here in every
+// build mode; only the functions that need sqrt or trig stay in vec3.inl.
+constexpr vec3 operator+(const vec3 &l, const vec3 &r) {
+  return vec3(l.x + r.x, l.y + r.y, l.z + r.z);
+}
+
+constexpr vec3 operator-(const vec3 &l, const vec3 &r) {
+  return vec3(l.x - r.x, l.y - r.y, l.z - r.z);
+}
+
+constexpr vec3 operator*(const vec3 &v, float f) {
+  return vec3(v.x * f, v.y * f, v.z * f);
+}
+
+constexpr vec3 operator*(const vec3 &l, const vec3 &r) {
+  return vec3(l.x * r.x, l.y * r.y, l.z * r.z);
+}
+
+constexpr float dot(const vec3 &l, const vec3 &r) {
+  return l.x * r.x + l.y * r.y + l.z * r.z;
+}
+
+constexpr float lenSq(const vec3 &v) {
+  return v.x * v.x + v.y * v.y + v.z * v.z;
+}
+
+constexpr float toRadians(float degrees) {
+  constexpr double pi = 3.14159265358979323846;
+  return (float)(degrees * (pi / 180));
+}
+
+constexpr vec3 cross(const vec3 &l, const vec3 &r) {
+  return vec3(l.y * r.z - l.z * r.y, l.z * r.x - l.x * r.z,
+              l.x * r.y - l.y * r.x);
+}
+
+constexpr vec3 lerp(const vec3 &s, const vec3 &e, float t) {
+  return vec3(s.x + (e.x - s.x) * t, s.y + (e.y - s.y) * t,
+              s.z + (e.z - s.z) * t);
+}
+
+constexpr bool operator==(const vec3 &l, const vec3 &r) {
+  return lenSq(l - r) < VEC3_EPSILON;
+}
+
+constexpr bool operator!=(const vec3 &l, const vec3 &r) { return !(l == r); }
+
 float len(const vec3 &v);
-float toRadians(float degrees);
 void normalize(vec3 &v);
 vec3 normalized(const vec3 &v);
 float angle(const vec3 &l, const vec3 &r);
 vec3 project(const vec3 &a, const vec3 &b);
 vec3 reject(const vec3 &a, const vec3 &b);
 vec3 reflect(const vec3 &a, const vec3 &b);
-vec3 cross(const vec3 &a, const vec3 &b);
-vec3 lerp(const vec3 &s, const vec3 &e, float t);
 vec3 slerp(const vec3 &s, const vec3 &e, float t);
 vec3 nlerp(const vec3 &s, const vec3 &e, float t);
-
-bool operator==(const vec3 &l, const vec3 &r);
-bool operator!=(const vec3 &l, const vec3 &r);
 std::ostream &operator<<(std::ostream &stream, const vec3 &v);
+
+#ifdef MATHS_HEADER_ONLY
+#include "vec3.inl"
+#endif
@@ -0,0 +1,100 @@
+#pragma once
+#include <math.h>
+
+MATHS_INLINE float len(const vec3 &v) {
+  float lenSq = v.x * v.x + v.y * v.y + v.z * v.z;
+  if (lenSq < VEC3_EPSILON) {
+    return 0.0f;
+  }
+  return sqrtf(lenSq);
+}
+
+MATHS_INLINE void normalize(vec3 &v) {
+  float lenSq = v.x * v.x + v.y * v.y + v.z * v.z;
+  if (lenSq < VEC3_EPSILON) {
+    return;
+  }
+  float invLen = 1.0f / sqrtf(lenSq);
+
+  v.x *= invLen;
+  v.y *= invLen;
+  v.z *= invLen;
+}
+
+MATHS_INLINE vec3 normalized(const vec3 &v) {
+  float lenSq = v.x * v.x + v.y * v.y + v.z * v.z;
+  if (lenSq < VEC3_EPSILON) {
+    return v;
+  }
+  float invLen = 1.0f / sqrtf(lenSq);
+
+  return vec3(v.x * invLen, v.y * invLen, v.z * invLen);
+}
+
+MATHS_INLINE float angle(const vec3 &l, const vec3 &r) {
+  float sqMagL = l.x * l.x + l.y * l.y + l.z * l.z;
+  float sqMagR = r.x * r.x + r.y * r.y + r.z * r.z;
+
+  if (sqMagL < VEC3_EPSILON || sqMagR < VEC3_EPSILON) {
+    return 0.0f;
+  }
+
+  float dot = l.x * r.x + l.y * r.y + l.z * r.z;
+  float len = sqrtf(sqMagL) * sqrtf(sqMagR);
+  return acosf(dot / len);
+}
+
+MATHS_INLINE vec3 project(const vec3 &a, const vec3 &b) {
+  float magBSq = len(b);
+  if (magBSq < VEC3_EPSILON) {
+    return vec3();
+  }
+  float scale = dot(a, b) / magBSq;
+  return b * scale;
+}
+
+MATHS_INLINE vec3 reject(const vec3 &a, const vec3 &b) {
+  vec3 projection = project(a, b);
+  return a - projection;
+}
+
+MATHS_INLINE vec3 reflect(const vec3 &a, const vec3 &b) {
+  float magBSq = len(b);
+  if (magBSq < VEC3_EPSILON) {
+    return vec3();
+  }
+  float scale = dot(a, b) / magBSq;
+  vec3 proj2 = b * (scale * 2);
+  return a - proj2;
+}
+
+MATHS_INLINE vec3 slerp(const vec3 &s, const vec3 &e, float t) {
+  if (t < 0.01f) {
+    return lerp(s, e, t);
+  }
+
+  vec3 from = normalized(s);
+  vec3 to = normalized(e);
+
+  float theta = angle(from, to);
+  float sin_theta = sinf(theta);
+
+  float a = sinf((1.0f - t) * theta) / sin_theta;
+  float b = sinf(t * theta) / sin_theta;
+
+  return from * a + to * b;
+}
+
+MATHS_INLINE vec3 nlerp(const vec3 &s, const vec3 &e, float t) {
+  vec3 linear(s.x + (e.x - s.x) * t, s.y + (e.y - s.y) * t,
+              s.z + (e.z - s.z) * t);
+  return normalized(linear);
+}
+
+MATHS_INLINE std::ostream &operator<<(std::ostream &stream, const vec3 &v) {
+  stream << v.x << " " << v.y << " " << v.z;
+  stream << ""
+         << "\n";
+
+  return stream;
+}
@@ -0,0 +1,217 @@
+#include "animation.h"
+#include "parallel.h"
+#include <algorithm>
+#include <math.h>
+
+static inline int components(TrackTarget target) {
+  return target == TrackTarget::Rotation ? 4 : 3;
+}
+
+static unsigned int valueStride(TrackTarget target,
+                                Interpolation interpolation) {
+  unsigned int stride = components(target);
+  return interpolation == Interpolation::Cubic ? stride * 3 : stride;
+}
+
+// Erases the keys of the track and moves the tracks stored after it down.
+static void removeKeys(AnimationClip &clip, AnimationTrack &track,
+                       unsigned int valueCount) {
+  unsigned int firstKey = track.firstKey, keyCount = track.keyCount;
+  unsigned int firstValue = track.firstValue;
+  clip.times.erase(clip.times.begin() + firstKey,
+                   clip.times.begin() + firstKey + keyCount);
+  clip.values.erase(clip.values.begin() + firstValue,
+                    clip.values.begin() + firstValue + valueCount);
+  track.keyCount = 0;
+  for (AnimationTrack &other : clip.tracks) {
+    if (other.keyCount > 0 && other.firstKey > firstKey) {
+      other.firstKey -= keyCount;
+      other.firstValue -= valueCount;
+    }
+  }
+}
+
+// Start and end over every track with keys
+static void updateRange(AnimationClip &clip) {
+  bool first = true;
+  for (const AnimationTrack &track : clip.tracks) {
+    if (track.keyCount == 0) {
+      continue;
+    }
+    float start = clip.times[track.firstKey];
+    float end = clip.times[track.firstKey + track.keyCount - 1];
+    clip.startTime = first ? start : std::min(clip.startTime, start);
+    clip.endTime = first ? end : std::max(clip.endTime, end);
+    first = false;
+  }
+  if (first) {
+    clip.startTime = clip.endTime = 0.0f;
+  }
+}
+
+void addTrack(AnimationClip &clip, unsigned int joint, TrackTarget target,
+              Interpolation interpolation, const float *times,
+              const float *values, unsigned int keyCount) {
+  AnimationTrack &track = clip.tracks[joint * 3 + (int)target];
+  bool replaced = track.keyCount > 0;
+  if (replaced) {
+    removeKeys(clip, track,
+               track.keyCount * valueStride(target, track.interpolation));
+  }
+  if (keyCount > 0) {
+    unsigned int stride = valueStride(target, interpolation);
+    track.firstKey = (unsigned int)clip.times.size();
+    track.firstValue = (unsigned int)clip.values.size();
+    track.keyCount = keyCount;
+    track.interpolation = interpolation;
+    clip.times.insert(clip.times.end(), times, times + keyCount);
+    clip.values.insert(clip.values.end(), values, values + keyCount * stride);
+  }
+  if (replaced) {
+    updateRange(clip);
+  } else if (keyCount > 0) {
+    bool first = clip.times.size() == keyCount;
+    clip.startTime = first ? times[0] : std::min(clip.startTime, times[0]);
+    clip.endTime = first ? times[keyCount - 1]
+                         : std::max(clip.endTime, times[keyCount - 1]);
+  }
+}
+
+float adjustTime(const AnimationClip &clip, float time) {
+  float duration = clip.endTime - clip.startTime;
+  if (duration <= 0.0f) {
+    return clip.startTime;
+  }
+  if (clip.looping) {
+    time = fmodf(time - clip.startTime, duration);
+    if (time < 0.0f) {
+      time += duration;
+    }
+    return time + clip.startTime;
+  }
+  return std::min(std::max(time, clip.startTime), clip.endTime);
+}
+
+// Index k of the key with times[k] <= t < times[k + 1]; t is already inside
+// the track range. Sequential playback usually finds it within a few steps
+// of the cached key, anything else falls back to a binary search.
+static unsigned int findKey(const float *times, unsigned int keyCount, float t,
+                            unsigned int *cursor) {
+  unsigned int k = cursor ? *cursor : 0;
+  if (k + 1 >= keyCount || t < times[k]) {
+    k = 0;
+  }
+  for (int step = 0; step < 4 && k + 2 < keyCount && t >= times[k + 1];
+       ++step) {
+    ++k;
+  }
+  if (k + 2 < keyCount && t >= times[k + 1]) {
+    k = (unsigned int)(std::upper_bound(times + k, times + keyCount, t) -
+                       times) -
+        1;
+  }
+  if (cursor) {
+    *cursor = k;
+  }
+  return k;
+}
+
+static inline float hermite(float t, float p1, float s1, float p2, float s2) {
+  float tt = t * t;
+  float ttt = tt * t;
+  float h1 = 2.0f * ttt - 3.0f * tt + 1.0f;
+  float h2 = -2.0f * ttt + 3.0f * tt;
+  float h3 = ttt - 2.0f * tt + t;
+  float h4 = ttt - tt;
+  return p1 * h1 + p2 * h2 + s1 * h3 + s2 * h4;
+}
+
+static void sampleTrack(const AnimationClip &clip, const AnimationTrack &track,
+                        int n, float t, unsigned int *cursor, float *out) {
+  const float *times = clip.times.data() + track.firstKey;
+  const float *values = clip.values.data() + track.firstValue;
+  bool cubic = track.interpolation == Interpolation::Cubic;
+  int stride = cubic ? n * 3 : n;
+  int offset = cubic ? n : 0; // skip the in tangent
+
+  unsigned int last = track.keyCount - 1;
+  if (track.keyCount == 1 || t <= times[0] || t >= times[last]) {
+    const float *v = values + (t <= times[0] ? 0 : last) * stride + offset;
+    for (int i = 0; i < n; ++i) {
+      out[i] = v[i];
+    }
+    return;
+  }
+
+  unsigned int k = findKey(times, track.keyCount, t, cursor);
+  const float *a = values + k * stride;
+  const float *b = a + stride;
+  if (track.interpolation == Interpolation::Constant) {
+    for (int i = 0; i < n; ++i) {
+      out[i] = a[i];
+    }
+    return;
+  }
+
+  float dt = times[k + 1] - times[k];
+  float f = (t - times[k]) / dt;
+  if (cubic) {
+    for (int i = 0; i < n; ++i) {
+      out[i] = hermite(f, a[n + i], a[2 * n + i] * dt, b[n + i], b[i] * dt);
+    }
+  } else {
+    // Rotations blend through the shorter arc like mix(Transform)
+    float s = 1.0f;
+    if (n == 4 && a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3] < 0) {
+      s = -1.0f;
+    }
+    for (int i = 0; i < n; ++i) {
+      out[i] = a[i] + (b[i] * s - a[i]) * f;
+    }
+  }
+  if (n == 4) {
+    quat q(out[0], out[1], out[2], out[3]);
+    normalize(q);
+    for (int i = 0; i < 4; ++i) {
+      out[i] = q.v[i];
+    }
+  }
+}
+
+void sampleClip(const AnimationClip &clip, float time, unsigned int *cursor,
+                Transform *pose) {
+  float t = adjustTime(clip, time);
+  unsigned int trackCount = (unsigned int)clip.tracks.size();
+  for (unsigned int i = 0; i < trackCount; ++i) {
+    const AnimationTrack &track = clip.tracks[i];
+    if (track.keyCount == 0) {
+      continue;
+    }
+    Transform &joint = pose[i / 3];
+    unsigned int *c = cursor ? cursor + i : nullptr;
+    switch ((TrackTarget)(i % 3)) {
+    case TrackTarget::Position:
+      sampleTrack(clip, track, 3, t, c, joint.position.v);
+      break;
+    case TrackTarget::Rotation:
+      sampleTrack(clip, track, 4, t, c, joint.rotation.v);
+      break;
+    case TrackTarget::Scale:
+      sampleTrack(clip, track, 3, t, c, joint.scale.v);
+      break;
+    }
+  }
+}
+
+void sampleClips(const ClipSample *samples, unsigned int count) {
+  for (unsigned int i = 0; i < count; ++i) {
+    const ClipSample &s = samples[i];
+    sampleClip(*s.clip, s.time, s.cursor, s.pose);
+  }
+}
+
+void sampleClipsParallel(const ClipSample *samples, unsigned int count) {
+  parallelFor(count, 16, [&](unsigned int begin, unsigned int end) {
+    sampleClips(samples + begin, end - begin);
+  });
+}
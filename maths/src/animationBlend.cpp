@@ -0,0 +1,118 @@
+#include "animation.h"
+#include "transformSimd.h"
+
+void makeAdditivePose(const Transform *pose, const Transform *reference,
+                      Transform *delta, unsigned int jointCount) {
+  for (unsigned int i = 0; i < jointCount; ++i) {
+    delta[i] = combine(inverse(reference[i]), pose[i]);
+  }
+}
+
+// weight times the joint mask for the joints in j, which are consecutive
+// except in the last block
+static inline f4 layerWeights(const PoseLayer &layer,
+                              const unsigned int j[4]) {
+  f4 w = f4Splat(layer.weight);
+  const float *m = layer.jointWeights;
+  if (!m) {
+    return w;
+  }
+  f4 mask = j[3] == j[0] + 3 ? f4Load(m + j[0])
+                             : f4Set(m[j[0]], m[j[1]], m[j[2]], m[j[3]]);
+  return f4Mul(w, mask);
+}
+
+static inline TransformX4 loadLayer(const PoseLayer &layer,
+                                    const unsigned int j[4]) {
+  const Transform *p = layer.pose;
+  return loadTransformX4(p + j[0], p + j[1], p + j[2], p + j[3]);
+}
+
+static inline vec3X4 select(f4 mask, const vec3X4 &a, const vec3X4 &b) {
+  return {f4Select(mask, a.x, b.x), f4Select(mask, a.y, b.y),
+          f4Select(mask, a.z, b.z)};
+}
+
+// Weighted average of the normal layers, the identity where the weights sum
+// to zero
+static TransformX4 blendNormal(const PoseLayer *layers,
+                               unsigned int layerCount,
+                               const unsigned int j[4]) {
+  f4 zero = f4Splat(0.0f), one = f4Splat(1.0f);
+  vec3X4 position = {zero, zero, zero}, scale = {zero, zero, zero};
+  quatX4 rotation = {zero, zero, zero, zero}, hemisphere = rotation;
+  f4 total = zero;
+  bool first = true;
+  for (unsigned int l = 0; l < layerCount; ++l) {
+    if (layers[l].additive) {
+      continue;
+    }
+    TransformX4 t = loadLayer(layers[l], j);
+    f4 w = layerWeights(layers[l], j);
+    if (first) {
+      hemisphere = t.rotation;
+      first = false;
+    }
+    position = position + t.position * w;
+    f4 alignedW = f4MulSign(w, dot(hemisphere, t.rotation));
+    rotation = rotation + t.rotation * alignedW;
+    scale = scale + t.scale * w;
+    total = f4Add(total, w);
+  }
+
+  f4 lenSq = dot(rotation, rotation);
+  f4 weighted = f4Less(zero, total);
+  f4 rotated = f4Less(zero, lenSq);
+  f4 invTotal = f4Div(one, total);
+  f4 invLen = f4Div(one, f4Sqrt(lenSq));
+
+  TransformX4 r;
+  r.position = select(weighted, position * invTotal, {zero, zero, zero});
+  r.scale = select(weighted, scale * invTotal, {one, one, one});
+  r.rotation = {f4Select(rotated, f4Mul(rotation.x, invLen), zero),
+                f4Select(rotated, f4Mul(rotation.y, invLen), zero),
+                f4Select(rotated, f4Mul(rotation.z, invLen), zero),
+                f4Select(rotated, f4Mul(rotation.w, invLen), one)};
+  return r;
+}
+
+// mix(Transform(), delta, w): the delta rotation is taken on the positive w
+// hemisphere and nlerped from the identity.
+static inline TransformX4 scaleDelta(const TransformX4 &delta, f4 w) {
+  f4 one = f4Splat(1.0f);
+  const quatX4 &q = delta.rotation;
+  f4 signedW = f4MulSign(w, q.w);
+  quatX4 rotation = {f4Mul(q.x, signedW), f4Mul(q.y, signedW),
+                     f4Mul(q.z, signedW),
+                     f4MulAdd(q.w, signedW, f4Sub(one, w))};
+  f4 invLen = f4Div(one, f4Sqrt(dot(rotation, rotation)));
+
+  TransformX4 r;
+  r.position = delta.position * w;
+  r.rotation = rotation * invLen;
+  r.scale = {f4MulAdd(f4Sub(delta.scale.x, one), w, one),
+             f4MulAdd(f4Sub(delta.scale.y, one), w, one),
+             f4MulAdd(f4Sub(delta.scale.z, one), w, one)};
+  return r;
+}
+
+void blendPoses(const PoseLayer *layers, unsigned int layerCount,
+                Transform *out, unsigned int jointCount) {
+  for (unsigned int j0 = 0; j0 < jointCount; j0 += 4) {
+    // The last block repeats its final joint in the unused lanes; those
+    // lanes compute and store the same values again.
+    unsigned int last = jointCount - 1;
+    const unsigned int j[4] = {j0, j0 + 1 < last ? j0 + 1 : last,
+                               j0 + 2 < last ? j0 + 2 : last,
+                               j0 + 3 < last ? j0 + 3 : last};
+    TransformX4 result = blendNormal(layers, layerCount, j);
+    for (unsigned int l = 0; l < layerCount; ++l) {
+      if (layers[l].additive) {
+        result = combine(
+            result, scaleDelta(loadLayer(layers[l], j),
+                               layerWeights(layers[l], j)));
+      }
+    }
+    storeTransformX4(result, out + j[0], out + j[1], out + j[2], out + j[3]);
+  }
+}
@@ -0,0 +1,16 @@
+#pragma once
+// Entry points of the translation units built with AVX2/FMA flags. Only call
+// them after cpuHasAvx2() returned true. This header is included from those
+// translation units, so it must not pull in any inline code of its own.
+
+// Transforms packed xyz triples (AoS) or separate x/y/z streams (SoA) by the
+// column-major matrix m. The fourth coordinate is read from and written back
+// to w when it is not null, otherwise it is the constant translate.
+void transformAosAvx2(const float *m, const float *in, float *out, float *w,
+                      float translate, unsigned int count);
+void transformSoaAvx2(const float *m, const float *x, const float *y,
+                      const float *z, float *outX, float *outY, float *outZ,
+                      float *w, float translate, unsigned int count);
+
+// Column-major 4x4 product a * b, two result columns per iteration.
+void mat4MulAvx2(const float *a, const float *b, float *out);
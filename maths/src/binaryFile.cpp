@@ -0,0 +1,460 @@
+#include "binaryFile.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(BinaryFileHeader) == 24, "BinaryFileHeader layout");
+static_assert(sizeof(BinarySectionHeader) == 32, "BinarySectionHeader layout");
+static_assert(sizeof(vec3) == 12 && sizeof(quat) == 16 && sizeof(mat4) == 64 &&
+                  sizeof(Transform) == 40 && sizeof(DualQuaternion) == 32,
+              "Section payloads are expected to be packed floats");
+
+static const unsigned int kMinMatch = 4;
+static const unsigned int kMaxOffset = 65535;
+static const unsigned int kHashBits = 14;
+// Every input byte of a stream decodes to fewer output bytes than this: a
+// length byte adds at most 255, and literals and match headers less.
+static const unsigned long long kMaxExpansion = 255;
+
+// Decoded Lz sections before they are unshuffled. Reused between calls on
+// the same thread.
+static thread_local std::vector<unsigned char> decodeScratch;
+
+static size_t elementSize(unsigned int type) {
+  switch ((BinaryType)type) {
+  case BinaryType::Vec3:
+    return sizeof(vec3);
+  case BinaryType::Quat:
+    return sizeof(quat);
+  case BinaryType::Mat4:
+    return sizeof(mat4);
+  case BinaryType::Transform:
+    return sizeof(Transform);
+  case BinaryType::DualQuaternion:
+    return sizeof(DualQuaternion);
+  }
+  return 0;
+}
+
+static size_t alignUp(size_t offset) {
+  return (offset + BINARY_FILE_ALIGNMENT - 1) &
+         ~(size_t)(BINARY_FILE_ALIGNMENT - 1);
+}
+
+// Byte k of every float goes to plane k, so the slowly changing sign and
+// exponent bytes of neighbouring values sit next to each other.
+static void shuffle(const unsigned char *in, unsigned char *out, size_t size) {
+  size_t words = size / 4;
+  for (size_t w = 0; w < words; ++w) {
+    for (size_t k = 0; k < 4; ++k) {
+      out[k * words + w] = in[w * 4 + k];
+    }
+  }
+}
+
+static void unshuffle(const unsigned char *in, unsigned char *out,
+                      size_t size) {
+  size_t words = size / 4;
+  for (size_t w = 0; w < words; ++w) {
+    for (size_t k = 0; k < 4; ++k) {
+      out[w * 4 + k] = in[k * words + w];
+    }
+  }
+}
+
+static unsigned int hash4(const unsigned char *p) {
+  unsigned int v;
+  memcpy(&v, p, 4);
+  return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+// Lengths from 15 on continue in bytes of 255 and a final smaller byte
+static void putLength(std::vector<unsigned char> &out, size_t length) {
+  for (; length >= 255; length -= 255) {
+    out.push_back(255);
+  }
+  out.push_back((unsigned char)length);
+}
+
+static bool getLength(const unsigned char *in, size_t size, size_t &pos,
+                      size_t &length) {
+  unsigned char b;
+  do {
+    if (pos >= size) {
+      return false;
+    }
+    b = in[pos++];
+    length += b;
+  } while (b == 255);
+  return true;
+}
+
+// A sequence is a token (literal count in the high nibble, match length - 4
+// in the low one), the literals, and unless it ends the stream, a 16-bit
+// match offset back into the output.
+static void putSequence(std::vector<unsigned char> &out,
+                        const unsigned char *literals, size_t literalCount,
+                        size_t offset, size_t matchLength) {
+  size_t match = matchLength ? matchLength - kMinMatch : 0;
+  out.push_back((unsigned char)((literalCount < 15 ? literalCount : 15) << 4 |
+                                (match < 15 ? match : 15)));
+  if (literalCount >= 15) {
+    putLength(out, literalCount - 15);
+  }
+  out.insert(out.end(), literals, literals + literalCount);
+  if (matchLength) {
+    out.push_back((unsigned char)offset);
+    out.push_back((unsigned char)(offset >> 8));
+    if (match >= 15) {
+      putLength(out, match - 15);
+    }
+  }
+}
+
+// Greedy LZ77 with a single-entry hash table of earlier positions.
+static void compressLz(const unsigned char *in, size_t size,
+                       std::vector<unsigned char> &out) {
+  std::vector<size_t> table((size_t)1 << kHashBits, 0);
+  size_t anchor = 0;
+  size_t i = 0;
+  while (i + kMinMatch <= size) {
+    unsigned int h = hash4(in + i);
+    size_t candidate = table[h];
+    table[h] = i;
+    if (candidate < i && i - candidate <= kMaxOffset &&
+        memcmp(in + candidate, in + i, kMinMatch) == 0) {
+      size_t length = kMinMatch;
+      while (i + length < size && in[candidate + length] == in[i + length]) {
+        ++length;
+      }
+      putSequence(out, in + anchor, i - anchor, i - candidate, length);
+      i += length;
+      anchor = i;
+    } else {
+      ++i;
+    }
+  }
+  putSequence(out, in + anchor, size - anchor, 0, 0);
+}
+
+// Every length and offset is checked, so corrupt input fails instead of
+// reading or writing out of bounds.
+static bool decompressLz(const unsigned char *in, size_t size,
+                         unsigned char *out, size_t outSize) {
+  size_t ip = 0;
+  size_t op = 0;
+  while (ip < size) {
+    unsigned int token = in[ip++];
+    size_t literals = token >> 4;
+    if (literals == 15 && !getLength(in, size, ip, literals)) {
+      return false;
+    }
+    if (literals > size - ip || literals > outSize - op) {
+      return false;
+    }
+    memcpy(out + op, in + ip, literals);
+    ip += literals;
+    op += literals;
+    if (ip == size) {
+      break;
+    }
+    if (size - ip < 2) {
+      return false;
+    }
+    size_t offset = in[ip] | (size_t)in[ip + 1] << 8;
+    ip += 2;
+    size_t length = (token & 15) + kMinMatch;
+    if ((token & 15) == 15 && !getLength(in, size, ip, length)) {
+      return false;
+    }
+    if (offset == 0 || offset > op || length > outSize - op) {
+      return false;
+    }
+    const unsigned char *match = out + op - offset;
+    if (offset >= length) {
+      memcpy(out + op, match, length);
+    } else {
+      // Overlapping copies repeat the last offset bytes
+      for (size_t k = 0; k < length; ++k) {
+        out[op + k] = match[k];
+      }
+    }
+    op += length;
+  }
+  return op == outSize;
+}
+
+void writeBinaryFile(const BinarySectionDesc *sections,
+                     unsigned int sectionCount,
+                     std::vector<unsigned char> &out) {
+  std::vector<BinarySectionHeader> table(sectionCount);
+  size_t tableEnd =
+      sizeof(BinaryFileHeader) + sectionCount * sizeof(BinarySectionHeader);
+  out.assign(alignUp(tableEnd), 0);
+  std::vector<unsigned char> shuffled;
+  std::vector<unsigned char> packed;
+  for (unsigned int s = 0; s < sectionCount; ++s) {
+    const BinarySectionDesc &desc = sections[s];
+    const unsigned char *data = (const unsigned char *)desc.data;
+    size_t size = desc.count * elementSize((unsigned int)desc.type);
+    BinarySectionHeader &h = table[s];
+    h.id = desc.id;
+    h.type = (unsigned int)desc.type;
+    h.compression = (unsigned int)BinaryCompression::None;
+    h.count = desc.count;
+    if (desc.compression == BinaryCompression::Lz && size > 0) {
+      shuffled.resize(size);
+      shuffle(data, shuffled.data(), size);
+      packed.clear();
+      compressLz(shuffled.data(), size, packed);
+      if (packed.size() < size) {
+        h.compression = (unsigned int)BinaryCompression::Lz;
+        data = packed.data();
+        size = packed.size();
+      }
+    }
+    out.resize(alignUp(out.size()), 0);
+    h.offset = out.size();
+    h.size = size;
+    out.insert(out.end(), data, data + size);
+  }
+
+  BinaryFileHeader header = {BINARY_FILE_MAGIC, BINARY_FILE_VERSION,
+                             sectionCount, 0, out.size()};
+  memcpy(out.data(), &header, sizeof(header));
+  if (sectionCount) {
+    memcpy(out.data() + sizeof(header), table.data(),
+           sectionCount * sizeof(BinarySectionHeader));
+  }
+}
+
+bool saveBinaryFile(const char *path, const BinarySectionDesc *sections,
+                    unsigned int sectionCount) {
+  std::vector<unsigned char> image;
+  writeBinaryFile(sections, sectionCount, image);
+  FILE *f = fopen(path, "wb");
+  if (!f) {
+    return false;
+  }
+  bool ok = fwrite(image.data(), 1, image.size(), f) == image.size();
+  return fclose(f) == 0 && ok;
+}
+
+BinaryStatus openBinaryFile(const void *data, size_t size, BinaryFile &file) {
+  const unsigned char *bytes = (const unsigned char *)data;
+  if (size < sizeof(BinaryFileHeader)) {
+    return BinaryStatus::Truncated;
+  }
+  const BinaryFileHeader *header = (const BinaryFileHeader *)bytes;
+  if (header->magic != BINARY_FILE_MAGIC) {
+    unsigned int m = header->magic;
+    unsigned int swapped = m >> 24 | (m >> 8 & 0xFF00u) |
+                           (m << 8 & 0xFF0000u) | m << 24;
+    return swapped == BINARY_FILE_MAGIC ? BinaryStatus::WrongEndianness
+                                        : BinaryStatus::BadMagic;
+  }
+  if (header->version == 0 || header->version > BINARY_FILE_VERSION) {
+    return BinaryStatus::UnsupportedVersion;
+  }
+  unsigned long long fileSize = header->fileSize;
+  if (fileSize > size ||
+      sizeof(BinaryFileHeader) +
+              (unsigned long long)header->sectionCount *
+                  sizeof(BinarySectionHeader) >
+          fileSize) {
+    return BinaryStatus::Truncated;
+  }
+  const BinarySectionHeader *sections =
+      (const BinarySectionHeader *)(bytes + sizeof(BinaryFileHeader));
+  for (unsigned int s = 0; s < header->sectionCount; ++s) {
+    const BinarySectionHeader &h = sections[s];
+    size_t element = elementSize(h.type);
+    unsigned long long raw = (unsigned long long)h.count * element;
+    bool compressed = h.compression == (unsigned int)BinaryCompression::Lz;
+    // Compressed sections are only written when they are smaller, and can
+    // not decode to more than kMaxExpansion bytes per stored byte
+    if (element == 0 ||
+        (!compressed &&
+         h.compression != (unsigned int)BinaryCompression::None) ||
+        (!compressed && h.size != raw) ||
+        (compressed && (h.size >= raw || raw > h.size * kMaxExpansion)) ||
+        h.offset % BINARY_FILE_ALIGNMENT != 0 || h.offset > fileSize ||
+        h.size > fileSize - h.offset) {
+      return BinaryStatus::BadSection;
+    }
+  }
+  file.data = bytes;
+  file.size = (size_t)fileSize;
+  file.header = header;
+  file.sections = sections;
+  return BinaryStatus::Ok;
+}
+
+const BinarySectionHeader *findSection(const BinaryFile &file,
+                                       unsigned int id) {
+  for (unsigned int s = 0; s < file.header->sectionCount; ++s) {
+    if (file.sections[s].id == id) {
+      return &file.sections[s];
+    }
+  }
+  return nullptr;
+}
+
+template <typename T>
+static bool getTyped(const BinaryFile &file, unsigned int id, BinaryType type,
+                     const T *&data, unsigned int &count) {
+  const BinarySectionHeader *h = findSection(file, id);
+  if (!h || h->type != (unsigned int)type ||
+      h->compression != (unsigned int)BinaryCompression::None) {
+    return false;
+  }
+  const unsigned char *p = file.data + h->offset;
+  if ((uintptr_t)p % alignof(T) != 0) {
+    return false;
+  }
+  data = (const T *)p;
+  count = h->count;
+  return true;
+}
+
+bool getSection(const BinaryFile &file, unsigned int id, const vec3 *&data,
+                unsigned int &count) {
+  return getTyped(file, id, BinaryType::Vec3, data, count);
+}
+
+bool getSection(const BinaryFile &file, unsigned int id, const quat *&data,
+                unsigned int &count) {
+  return getTyped(file, id, BinaryType::Quat, data, count);
+}
+
+bool getSection(const BinaryFile &file, unsigned int id, const mat4 *&data,
+                unsigned int &count) {
+  return getTyped(file, id, BinaryType::Mat4, data, count);
+}
+
+bool getSection(const BinaryFile &file, unsigned int id,
+                const Transform *&data, unsigned int &count) {
+  return getTyped(file, id, BinaryType::Transform, data, count);
+}
+
+bool getSection(const BinaryFile &file, unsigned int id,
+                const DualQuaternion *&data, unsigned int &count) {
+  return getTyped(file, id, BinaryType::DualQuaternion, data, count);
+}
+
+static bool readTyped(const BinaryFile &file, unsigned int id,
+                      BinaryType type, void *out, unsigned int capacity) {
+  const BinarySectionHeader *h = findSection(file, id);
+  if (!h || h->type != (unsigned int)type || h->count > capacity) {
+    return false;
+  }
+  const unsigned char *p = file.data + h->offset;
+  size_t size = h->count * elementSize(h->type);
+  if (h->compression == (unsigned int)BinaryCompression::None) {
+    if (size > 0) {
+      memcpy(out, p, size);
+    }
+    return true;
+  }
+  decodeScratch.resize(size);
+  if (!decompressLz(p, (size_t)h->size, decodeScratch.data(), size)) {
+    return false;
+  }
+  unshuffle(decodeScratch.data(), (unsigned char *)out, size);
+  return true;
+}
+
+bool readSection(const BinaryFile &file, unsigned int id, vec3 *out,
+                 unsigned int capacity) {
+  return readTyped(file, id, BinaryType::Vec3, out, capacity);
+}
+
+bool readSection(const BinaryFile &file, unsigned int id, quat *out,
+                 unsigned int capacity) {
+  return readTyped(file, id, BinaryType::Quat, out, capacity);
+}
+
+bool readSection(const BinaryFile &file, unsigned int id, mat4 *out,
+                 unsigned int capacity) {
+  return readTyped(file, id, BinaryType::Mat4, out, capacity);
+}
+
+bool readSection(const BinaryFile &file, unsigned int id, Transform *out,
+                 unsigned int capacity) {
+  return readTyped(file, id, BinaryType::Transform, out, capacity);
+}
+
+bool readSection(const BinaryFile &file, unsigned int id,
+                 DualQuaternion *out, unsigned int capacity) {
+  return readTyped(file, id, BinaryType::DualQuaternion, out, capacity);
+}
+
+#ifdef _WIN32
+bool mapFile(const char *path, MappedFile &file) {
+  HANDLE f = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (f == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size;
+  HANDLE mapping = nullptr;
+  if (GetFileSizeEx(f, &size) && size.QuadPart > 0) {
+    mapping = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  }
+  CloseHandle(f);
+  if (!mapping) {
+    return false;
+  }
+  const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!data) {
+    CloseHandle(mapping);
+    return false;
+  }
+  file = {data, (size_t)size.QuadPart, mapping};
+  return true;
+}
+
+void unmapFile(MappedFile &file) {
+  if (file.data) {
+    UnmapViewOfFile(file.data);
+    CloseHandle((HANDLE)file.handle);
+  }
+  file = {nullptr, 0, nullptr};
+}
+#else
+bool mapFile(const char *path, MappedFile &file) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  void *data = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  file = {data, (size_t)st.st_size, nullptr};
+  return true;
+}
+
+void unmapFile(MappedFile &file) {
+  if (file.data) {
+    munmap((void *)file.data, file.size);
+  }
+  file = {nullptr, 0, nullptr};
+}
+#endif
@@ -0,0 +1,361 @@
+#include "bounds.h"
+#include "parallel.h"
+#include "transformSimd.h"
+#include <float.h>
+#include <math.h>
+#include <vector>
+
+static_assert(sizeof(Aabb) == 6 * sizeof(float),
+              "Aabb is expected to be six packed floats");
+
+Aabb emptyAabb() {
+  return {vec3(FLT_MAX, FLT_MAX, FLT_MAX), vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX)};
+}
+
+bool isEmpty(const Aabb &b) {
+  return b.min.x > b.max.x || b.min.y > b.max.y || b.min.z > b.max.z;
+}
+
+// Plain compares rather than fminf/fmaxf, which are library calls unless
+// NaNs are ruled out. A NaN in b leaves a unchanged.
+static inline vec3 minVec3(const vec3 &a, const vec3 &b) {
+  return vec3(b.x < a.x ? b.x : a.x, b.y < a.y ? b.y : a.y,
+              b.z < a.z ? b.z : a.z);
+}
+
+static inline vec3 maxVec3(const vec3 &a, const vec3 &b) {
+  return vec3(b.x > a.x ? b.x : a.x, b.y > a.y ? b.y : a.y,
+              b.z > a.z ? b.z : a.z);
+}
+
+Aabb merge(const Aabb &a, const Aabb &b) {
+  return {minVec3(a.min, b.min), maxVec3(a.max, b.max)};
+}
+
+Aabb merge(const Aabb &b, const vec3 &p) {
+  return {minVec3(b.min, p), maxVec3(b.max, p)};
+}
+
+Aabb transformAabb(const mat4 &m, const Aabb &b) {
+  if (isEmpty(b)) {
+    return b;
+  }
+  Aabb r = {vec3(m.v[12], m.v[13], m.v[14]), vec3(m.v[12], m.v[13], m.v[14])};
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      float a = m.v[j * 4 + i] * b.min.v[j];
+      float c = m.v[j * 4 + i] * b.max.v[j];
+      r.min.v[i] += a < c ? a : c;
+      r.max.v[i] += a < c ? c : a;
+    }
+  }
+  return r;
+}
+
+Aabb transformAabb(const Transform &t, const Aabb &b) {
+  return transformAabb(transformToMat4(t), b);
+}
+
+Sphere transformSphere(const mat4 &m, const Sphere &s) {
+  float scaleSq = 0.0f;
+  for (int c = 0; c < 3; ++c) {
+    vec3 axis(m.v[c * 4], m.v[c * 4 + 1], m.v[c * 4 + 2]);
+    scaleSq = fmaxf(scaleSq, lenSq(axis));
+  }
+  return {transformPoint(m, s.center), s.radius * sqrtf(scaleSq)};
+}
+
+void transformAabbs(const mat4 *m, const Aabb *in, Aabb *out,
+                    unsigned int count) {
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    f4 cols[4][4];
+    loadMat4X4(m + i, m + i + 1, m + i + 2, m + i + 3, cols);
+    const float *const p[4] = {in[i].min.v, in[i + 1].min.v, in[i + 2].min.v,
+                               in[i + 3].min.v};
+    // Six floats per box, moved with two overlapping transposes
+    vec3X4 lo, hi;
+    f4 unused0, unused1;
+    loadTransposed(p, 0, lo.x, lo.y, lo.z, hi.x);
+    loadTransposed(p, 2, unused0, unused1, hi.y, hi.z);
+    const f4 *los[3] = {&lo.x, &lo.y, &lo.z};
+    const f4 *his[3] = {&hi.x, &hi.y, &hi.z};
+    f4 rmin[3], rmax[3];
+    for (int r = 0; r < 3; ++r) {
+      rmin[r] = cols[3][r];
+      rmax[r] = cols[3][r];
+      for (int c = 0; c < 3; ++c) {
+        f4 a = f4Mul(cols[c][r], *los[c]);
+        f4 b = f4Mul(cols[c][r], *his[c]);
+        rmin[r] = f4Add(rmin[r], f4Min(a, b));
+        rmax[r] = f4Add(rmax[r], f4Max(a, b));
+      }
+    }
+    // Empty boxes pass through unchanged
+    f4 empty = f4Or(f4Less(hi.x, lo.x),
+                    f4Or(f4Less(hi.y, lo.y), f4Less(hi.z, lo.z)));
+    for (int r = 0; r < 3; ++r) {
+      rmin[r] = f4Select(empty, *los[r], rmin[r]);
+      rmax[r] = f4Select(empty, *his[r], rmax[r]);
+    }
+    float *const q[4] = {out[i].min.v, out[i + 1].min.v, out[i + 2].min.v,
+                         out[i + 3].min.v};
+    storeTransposed(q, 0, rmin[0], rmin[1], rmin[2], rmax[0]);
+    storeTransposed(q, 2, rmin[2], rmax[0], rmax[1], rmax[2]);
+  }
+  for (; i < count; ++i) {
+    out[i] = transformAabb(m[i], in[i]);
+  }
+}
+
+// Point loaders for the reductions below: the points as stored, or after
+// transformPoint(m, p).
+namespace {
+struct Untransformed {
+  vec3X4 operator()(const vec3X4 &p) const { return p; }
+  vec3 operator()(const vec3 &p) const { return p; }
+};
+
+struct Affine {
+  const mat4 &m;
+  f4 c[12];
+  explicit Affine(const mat4 &matrix) : m(matrix) {
+    for (int i = 0; i < 3; ++i) {
+      c[i] = f4Splat(m.v[i]);
+      c[3 + i] = f4Splat(m.v[4 + i]);
+      c[6 + i] = f4Splat(m.v[8 + i]);
+      c[9 + i] = f4Splat(m.v[12 + i]);
+    }
+  }
+  vec3X4 operator()(const vec3X4 &p) const {
+    vec3X4 r;
+    f4 *out[3] = {&r.x, &r.y, &r.z};
+    for (int i = 0; i < 3; ++i) {
+      *out[i] = f4MulAdd(c[i], p.x,
+                         f4MulAdd(c[3 + i], p.y,
+                                  f4MulAdd(c[6 + i], p.z, c[9 + i])));
+    }
+    return r;
+  }
+  vec3 operator()(const vec3 &p) const { return transformPoint(m, p); }
+};
+} // namespace
+
+static inline float minLane(f4 a) {
+  float v[4];
+  f4Store(v, a);
+  return fminf(fminf(v[0], v[1]), fminf(v[2], v[3]));
+}
+
+static inline float maxLane(f4 a) {
+  float v[4];
+  f4Store(v, a);
+  return fmaxf(fmaxf(v[0], v[1]), fmaxf(v[2], v[3]));
+}
+
+static Aabb reduceLanes(const vec3X4 &lo, const vec3X4 &hi) {
+  return {vec3(minLane(lo.x), minLane(lo.y), minLane(lo.z)),
+          vec3(maxLane(hi.x), maxLane(hi.y), maxLane(hi.z))};
+}
+
+template <typename F>
+static Aabb aabbRange(const vec3 *points, unsigned int begin, unsigned int end,
+                      const F &load) {
+  vec3X4 lo = {f4Splat(FLT_MAX), f4Splat(FLT_MAX), f4Splat(FLT_MAX)};
+  vec3X4 hi = {f4Splat(-FLT_MAX), f4Splat(-FLT_MAX), f4Splat(-FLT_MAX)};
+  unsigned int i = begin;
+  for (; i + 4 <= end; i += 4) {
+    vec3X4 p;
+    f4Load3(points[i].v, p.x, p.y, p.z);
+    p = load(p);
+    lo = {f4Min(lo.x, p.x), f4Min(lo.y, p.y), f4Min(lo.z, p.z)};
+    hi = {f4Max(hi.x, p.x), f4Max(hi.y, p.y), f4Max(hi.z, p.z)};
+  }
+  Aabb r = reduceLanes(lo, hi);
+  for (; i < end; ++i) {
+    r = merge(r, load(points[i]));
+  }
+  return r;
+}
+
+template <typename F>
+static float maxDistSqRange(const vec3 *points, const vec3 &center,
+                            unsigned int begin, unsigned int end,
+                            const F &load) {
+  vec3X4 c = {f4Splat(center.x), f4Splat(center.y), f4Splat(center.z)};
+  f4 best = f4Splat(0.0f);
+  unsigned int i = begin;
+  for (; i + 4 <= end; i += 4) {
+    vec3X4 p;
+    f4Load3(points[i].v, p.x, p.y, p.z);
+    p = load(p);
+    vec3X4 d = {f4Sub(p.x, c.x), f4Sub(p.y, c.y), f4Sub(p.z, c.z)};
+    best = f4Max(best, dot(d, d));
+  }
+  float r = maxLane(best);
+  for (; i < end; ++i) {
+    r = fmaxf(r, lenSq(load(points[i]) - center));
+  }
+  return r;
+}
+
+static Sphere sphereAround(const Aabb &box, float maxDistSq) {
+  return {(box.min + box.max) * 0.5f, sqrtf(maxDistSq)};
+}
+
+template <typename F>
+static Sphere sphereRange(const vec3 *points, unsigned int count,
+                          const F &load) {
+  if (count == 0) {
+    return {vec3(), -1.0f};
+  }
+  Aabb box = aabbRange(points, 0, count, load);
+  vec3 center = (box.min + box.max) * 0.5f;
+  return sphereAround(box, maxDistSqRange(points, center, 0, count, load));
+}
+
+Aabb computeAabb(const vec3 *points, unsigned int count) {
+  return aabbRange(points, 0, count, Untransformed());
+}
+
+Aabb computeAabb(const Vec3SoA &points, unsigned int count) {
+  vec3X4 lo = {f4Splat(FLT_MAX), f4Splat(FLT_MAX), f4Splat(FLT_MAX)};
+  vec3X4 hi = {f4Splat(-FLT_MAX), f4Splat(-FLT_MAX), f4Splat(-FLT_MAX)};
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    vec3X4 p = {f4Load(points.x + i), f4Load(points.y + i),
+                f4Load(points.z + i)};
+    lo = {f4Min(lo.x, p.x), f4Min(lo.y, p.y), f4Min(lo.z, p.z)};
+    hi = {f4Max(hi.x, p.x), f4Max(hi.y, p.y), f4Max(hi.z, p.z)};
+  }
+  Aabb r = reduceLanes(lo, hi);
+  for (; i < count; ++i) {
+    r = merge(r, vec3(points.x[i], points.y[i], points.z[i]));
+  }
+  return r;
+}
+
+Aabb computeAabb(const mat4 &m, const vec3 *points, unsigned int count) {
+  return aabbRange(points, 0, count, Affine(m));
+}
+
+Aabb computeAabb(const Transform &t, const vec3 *points, unsigned int count) {
+  return computeAabb(transformToMat4(t), points, count);
+}
+
+Aabb computeAabb(const DualQuaternion &dq, const vec3 *points,
+                 unsigned int count) {
+  return computeAabb(dualQuatToTransform(dq), points, count);
+}
+
+Sphere computeSphere(const vec3 *points, unsigned int count) {
+  return sphereRange(points, count, Untransformed());
+}
+
+Sphere computeSphere(const mat4 &m, const vec3 *points, unsigned int count) {
+  return sphereRange(points, count, Affine(m));
+}
+
+Sphere computeSphere(const Transform &t, const vec3 *points,
+                     unsigned int count) {
+  return computeSphere(transformToMat4(t), points, count);
+}
+
+Sphere computeSphere(const DualQuaternion &dq, const vec3 *points,
+                     unsigned int count) {
+  return computeSphere(dualQuatToTransform(dq), points, count);
+}
+
+static const unsigned int kBoundsGrain = 16384;
+
+// Runs reduce(begin, end) over blocks of grain points in parallel and returns
+// the per-block results in order.
+template <typename T, typename F>
+static std::vector<T> reduceBlocks(unsigned int count, unsigned int grain,
+                                   const F &reduce) {
+  unsigned int blocks = (count + grain - 1) / grain;
+  std::vector<T> partial(blocks);
+  parallelFor(blocks, 1, [&](unsigned int first, unsigned int last) {
+    for (unsigned int b = first; b < last; ++b) {
+      unsigned int begin = b * grain;
+      unsigned int end = count - begin < grain ? count : begin + grain;
+      partial[b] = reduce(begin, end);
+    }
+  });
+  return partial;
+}
+
+template <typename F>
+static Aabb aabbParallel(const vec3 *points, unsigned int count,
+                         unsigned int grain, const F &load) {
+  std::vector<Aabb> partial = reduceBlocks<Aabb>(
+      count, grain ? grain : kBoundsGrain,
+      [&](unsigned int begin, unsigned int end) {
+        return aabbRange(points, begin, end, load);
+      });
+  return computeAabb(partial.data(), (unsigned int)partial.size());
+}
+
+template <typename F>
+static Sphere sphereParallel(const vec3 *points, unsigned int count,
+                             unsigned int grain, const F &load) {
+  if (count == 0) {
+    return {vec3(), -1.0f};
+  }
+  grain = grain ? grain : kBoundsGrain;
+  Aabb box = aabbParallel(points, count, grain, load);
+  vec3 center = (box.min + box.max) * 0.5f;
+  std::vector<float> partial = reduceBlocks<float>(
+      count, grain, [&](unsigned int begin, unsigned int end) {
+        return maxDistSqRange(points, center, begin, end, load);
+      });
+  float maxDistSq = 0.0f;
+  for (float d : partial) {
+    maxDistSq = fmaxf(maxDistSq, d);
+  }
+  return sphereAround(box, maxDistSq);
+}
+
+Aabb computeAabbParallel(const vec3 *points, unsigned int count,
+                         unsigned int grain) {
+  return aabbParallel(points, count, grain, Untransformed());
+}
+
+Aabb computeAabbParallel(const mat4 &m, const vec3 *points, unsigned int count,
+                         unsigned int grain) {
+  return aabbParallel(points, count, grain, Affine(m));
+}
+
+Sphere computeSphereParallel(const vec3 *points, unsigned int count,
+                             unsigned int grain) {
+  return sphereParallel(points, count, grain, Untransformed());
+}
+
+Sphere computeSphereParallel(const mat4 &m, const vec3 *points,
+                             unsigned int count, unsigned int grain) {
+  return sphereParallel(points, count, grain, Affine(m));
+}
+
+Aabb computeAabb(const Aabb *boxes, unsigned int count) {
+  Aabb r = emptyAabb();
+  for (unsigned int i = 0; i < count; ++i) {
+    r = merge(r, boxes[i]);
+  }
+  return r;
+}
+
+void mergeHierarchyBounds(const Aabb *bounds, const int *parents,
+                          Aabb *merged, unsigned int count) {
+  if (merged != bounds) {
+    for (unsigned int i = 0; i < count; ++i) {
+      merged[i] = bounds[i];
+    }
+  }
+  // Children come after their parents, so walking backwards folds every
+  // subtree into its root before the root is folded into its own parent.
+  for (unsigned int i = count; i-- > 0;) {
+    if (parents[i] >= 0) {
+      merged[parents[i]] = merge(merged[parents[i]], merged[i]);
+    }
+  }
+}
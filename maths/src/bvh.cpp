@@ -0,0 +1,727 @@
+#include "bvh.h"
+#include "parallel.h"
+#include "raySimd.h"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+static const unsigned int kLeafSize = 4;
+static const int kBins = 16;
+// Ranges at least this large are bounded and binned over parallelFor
+static const unsigned int kParallelRange = 65536;
+static const unsigned int kRangeGrain = 16384;
+// The Parallel builds hand ranges up to this size to a task of their own
+static const unsigned int kSubtreeSize = 8192;
+static const unsigned int kRefitGrain = 4096;
+
+// emptyAabb as a constant, for the bins reset on every split
+static const Aabb kEmptyBox = {vec3(FLT_MAX, FLT_MAX, FLT_MAX),
+                               vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX)};
+
+static_assert(sizeof(BvhNode) == 128, "BvhNode is expected to be two lines");
+
+namespace {
+struct Ref {
+  vec3 centroid;
+  unsigned int index;
+};
+
+// A run of refs, with the bounds of their boxes and of their centroids
+struct Range {
+  unsigned int begin;
+  unsigned int end;
+  Aabb box;
+  Aabb centroids;
+};
+
+struct Bins {
+  Aabb box[kBins];
+  Aabb centroids[kBins];
+  unsigned int count[kBins];
+};
+
+// A range left for a task of its own, and the slot that will point at it
+struct Subtree {
+  int node;
+  int slot;
+  Range range;
+  std::vector<BvhNode> nodes;
+};
+
+struct BuildContext {
+  const Aabb *boxes;
+  Ref *refs;
+  bool parallel;
+  std::vector<Subtree> *subtrees;
+};
+
+struct StackEntry {
+  int node;
+  float key;
+};
+
+// Traversal stack on the stack, moving to the heap only for unusually deep
+// trees.
+struct TraversalStack {
+  StackEntry local[64];
+  StackEntry *data = local;
+  unsigned int size = 0;
+  unsigned int capacity = 64;
+  std::vector<StackEntry> heap;
+
+  void push(const StackEntry &e) {
+    if (size == capacity) {
+      heap.resize(capacity * 2);
+      if (data == local) {
+        std::copy(local, local + size, heap.begin());
+      }
+      data = heap.data();
+      capacity *= 2;
+    }
+    data[size++] = e;
+  }
+
+  bool pop(StackEntry &e) {
+    if (size == 0) {
+      return false;
+    }
+    e = data[--size];
+    return true;
+  }
+
+  // Pushes furthest first, so the nearest child is visited next
+  void pushSorted(StackEntry *entries, int n) {
+    for (int i = 1; i < n; ++i) {
+      for (int j = i; j > 0 && entries[j - 1].key < entries[j].key; --j) {
+        std::swap(entries[j - 1], entries[j]);
+      }
+    }
+    for (int i = 0; i < n; ++i) {
+      push(entries[i]);
+    }
+  }
+};
+} // namespace
+
+// Inline merge for the build and refit loops, where the call would dominate
+static inline void grow(Aabb &box, const vec3 &lo, const vec3 &hi) {
+  box.min = vec3(lo.x < box.min.x ? lo.x : box.min.x,
+                 lo.y < box.min.y ? lo.y : box.min.y,
+                 lo.z < box.min.z ? lo.z : box.min.z);
+  box.max = vec3(hi.x > box.max.x ? hi.x : box.max.x,
+                 hi.y > box.max.y ? hi.y : box.max.y,
+                 hi.z > box.max.z ? hi.z : box.max.z);
+}
+
+static inline void grow(Aabb &box, const Aabb &b) { grow(box, b.min, b.max); }
+
+static inline void grow(Aabb &box, const vec3 &p) { grow(box, p, p); }
+
+// Inline isEmpty and vec3 math, as every split sweeps the bins with this
+static inline float halfArea(const Aabb &b) {
+  float dx = b.max.x - b.min.x, dy = b.max.y - b.min.y, dz = b.max.z - b.min.z;
+  if (dx < 0.0f || dy < 0.0f || dz < 0.0f) {
+    return 0.0f;
+  }
+  return dx * dy + dy * dz + dz * dx;
+}
+
+static void setSlot(BvhNode &node, int slot, const Aabb &box) {
+  node.minX[slot] = box.min.x;
+  node.minY[slot] = box.min.y;
+  node.minZ[slot] = box.min.z;
+  node.maxX[slot] = box.max.x;
+  node.maxY[slot] = box.max.y;
+  node.maxZ[slot] = box.max.z;
+}
+
+static inline float minLane(f4 a) {
+  a = f4Min(a, f4SwapPairs(a));
+  return f4First(f4Min(a, f4SwapHalves(a)));
+}
+
+static inline float maxLane(f4 a) {
+  a = f4Max(a, f4SwapPairs(a));
+  return f4First(f4Max(a, f4SwapHalves(a)));
+}
+
+static AabbX4 loadNodeX4(const BvhNode &node) {
+  return {{f4Load(node.minX), f4Load(node.minY), f4Load(node.minZ)},
+          {f4Load(node.maxX), f4Load(node.maxY), f4Load(node.maxZ)}};
+}
+
+// reduce(begin, end) over the range, split into blocks over parallelFor when
+// it is large enough, with the partial results folded by merge.
+template <typename T, typename F, typename M>
+static T reduceRange(const BuildContext &ctx, unsigned int begin,
+                     unsigned int end, const F &reduce, const M &merge) {
+  unsigned int count = end - begin;
+  if (!ctx.parallel || count < kParallelRange) {
+    return reduce(begin, end);
+  }
+  unsigned int blocks = (count + kRangeGrain - 1) / kRangeGrain;
+  std::vector<T> partial(blocks);
+  parallelFor(blocks, 1, [&](unsigned int first, unsigned int last) {
+    for (unsigned int b = first; b < last; ++b) {
+      unsigned int lo = begin + b * kRangeGrain;
+      partial[b] = reduce(lo, end - lo < kRangeGrain ? end : lo + kRangeGrain);
+    }
+  });
+  T result = partial[0];
+  for (unsigned int b = 1; b < blocks; ++b) {
+    result = merge(result, partial[b]);
+  }
+  return result;
+}
+
+static Range makeRange(const BuildContext &ctx, unsigned int begin,
+                       unsigned int end) {
+  struct Bounds {
+    Aabb box;
+    Aabb centroids;
+  };
+  Bounds b = reduceRange<Bounds>(
+      ctx, begin, end,
+      [&](unsigned int lo, unsigned int hi) {
+        Bounds r = {kEmptyBox, kEmptyBox};
+        for (unsigned int i = lo; i < hi; ++i) {
+          grow(r.box, ctx.boxes[ctx.refs[i].index]);
+          grow(r.centroids, ctx.refs[i].centroid);
+        }
+        return r;
+      },
+      [](Bounds a, const Bounds &b) {
+        grow(a.box, b.box);
+        grow(a.centroids, b.centroids);
+        return a;
+      });
+  return {begin, end, b.box, b.centroids};
+}
+
+// Splits the range in two along the longest centroid axis, at the bin
+// boundary with the lowest surface area cost. The bins carry the bounds of
+// both halves, so only the median fallback (for coinciding centroids, or
+// when every centroid lands on one side) needs another pass over them.
+static void splitRange(const BuildContext &ctx, const Range &range,
+                       Range &left, Range &right) {
+  unsigned int begin = range.begin, end = range.end;
+  vec3 extent = range.centroids.max - range.centroids.min;
+  int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2)
+                                 : (extent.y > extent.z ? 1 : 2);
+  Ref *refs = ctx.refs;
+  if (extent.v[axis] > 0.0f) {
+    float lo = range.centroids.min.v[axis];
+    float scale = kBins / extent.v[axis];
+    auto binOf = [=](const Ref &r) {
+      int bin = (int)((r.centroid.v[axis] - lo) * scale);
+      return bin < kBins - 1 ? bin : kBins - 1;
+    };
+    Bins bins = reduceRange<Bins>(
+        ctx, begin, end,
+        [&](unsigned int first, unsigned int last) {
+          Bins b;
+          for (int i = 0; i < kBins; ++i) {
+            b.box[i] = kEmptyBox;
+            b.centroids[i] = kEmptyBox;
+            b.count[i] = 0;
+          }
+          for (unsigned int i = first; i < last; ++i) {
+            int bin = binOf(refs[i]);
+            grow(b.box[bin], ctx.boxes[refs[i].index]);
+            grow(b.centroids[bin], refs[i].centroid);
+            ++b.count[bin];
+          }
+          return b;
+        },
+        [](Bins a, const Bins &b) {
+          for (int i = 0; i < kBins; ++i) {
+            grow(a.box[i], b.box[i]);
+            grow(a.centroids[i], b.centroids[i]);
+            a.count[i] += b.count[i];
+          }
+          return a;
+        });
+
+    // Cost of splitting after bin i: right side swept first, then left
+    float rightCost[kBins];
+    Aabb box = kEmptyBox;
+    unsigned int count = 0;
+    for (int i = kBins - 1; i > 0; --i) {
+      grow(box, bins.box[i]);
+      count += bins.count[i];
+      rightCost[i - 1] = halfArea(box) * count;
+    }
+    int bestBin = -1;
+    float bestCost = FLT_MAX;
+    box = kEmptyBox;
+    count = 0;
+    for (int i = 0; i < kBins - 1; ++i) {
+      grow(box, bins.box[i]);
+      count += bins.count[i];
+      float cost = halfArea(box) * count + rightCost[i];
+      if (cost < bestCost) {
+        bestCost = cost;
+        bestBin = i;
+      }
+    }
+    unsigned int split =
+        (unsigned int)(std::partition(refs + begin, refs + end,
+                                      [&](const Ref &r) {
+                                        return binOf(r) <= bestBin;
+                                      }) -
+                       refs);
+    if (split != begin && split != end) {
+      left = {begin, split, kEmptyBox, kEmptyBox};
+      right = {split, end, kEmptyBox, kEmptyBox};
+      for (int i = 0; i < kBins; ++i) {
+        Range &side = i <= bestBin ? left : right;
+        grow(side.box, bins.box[i]);
+        grow(side.centroids, bins.centroids[i]);
+      }
+      return;
+    }
+  }
+  unsigned int mid = begin + (end - begin) / 2;
+  std::nth_element(refs + begin, refs + mid, refs + end,
+                   [=](const Ref &a, const Ref &b) {
+                     return a.centroid.v[axis] < b.centroid.v[axis];
+                   });
+  left = makeRange(ctx, begin, mid);
+  right = makeRange(ctx, mid, end);
+}
+
+// Appends the node for the range and its subtree, and returns its index.
+// Up to four children are made by repeatedly splitting the largest range.
+static int buildNode(const BuildContext &ctx, std::vector<BvhNode> &nodes,
+                     const Range &range) {
+  int index = (int)nodes.size();
+  nodes.push_back(BvhNode());
+  Range ranges[4] = {range};
+  int n = 1;
+  while (n < 4) {
+    int largest = -1;
+    for (int i = 0; i < n; ++i) {
+      unsigned int size = ranges[i].end - ranges[i].begin;
+      if (size >= 2 && (largest < 0 || size > ranges[largest].end -
+                                                  ranges[largest].begin)) {
+        largest = i;
+      }
+    }
+    if (largest < 0) {
+      break;
+    }
+    Range split = ranges[largest];
+    splitRange(ctx, split, ranges[largest], ranges[n++]);
+  }
+
+  for (int slot = 0; slot < 4; ++slot) {
+    BvhNode &node = nodes[index];
+    if (slot >= n) {
+      setSlot(node, slot, kEmptyBox);
+      node.child[slot] = -1;
+      node.count[slot] = 0;
+      continue;
+    }
+    const Range &r = ranges[slot];
+    setSlot(node, slot, r.box);
+    node.count[slot] = 0;
+    if (r.end - r.begin <= kLeafSize) {
+      node.child[slot] = (int)r.begin;
+      node.count[slot] = r.end - r.begin;
+    } else if (ctx.subtrees && r.end - r.begin <= kSubtreeSize) {
+      node.child[slot] = -1;
+      ctx.subtrees->push_back({index, slot, r, {}});
+    } else {
+      int child = buildNode(ctx, nodes, r);
+      nodes[index].child[slot] = child;
+    }
+  }
+  return index;
+}
+
+static void build(Bvh &bvh, const Aabb *boxes, unsigned int count,
+                  bool parallel) {
+  std::vector<Ref> refs(count);
+  auto makeRefs = [&](unsigned int begin, unsigned int end) {
+    for (unsigned int i = begin; i < end; ++i) {
+      refs[i] = {(boxes[i].min + boxes[i].max) * 0.5f, i};
+    }
+  };
+  if (parallel) {
+    parallelFor(count, kRangeGrain, makeRefs);
+  } else {
+    makeRefs(0, count);
+  }
+
+  bvh.nodes.clear();
+  if (count > 0) {
+    std::vector<Subtree> subtrees;
+    BuildContext ctx = {boxes, refs.data(), parallel,
+                        parallel ? &subtrees : nullptr};
+    buildNode(ctx, bvh.nodes, makeRange(ctx, 0, count));
+
+    // The subtree ranges are disjoint, so the tasks share refs safely
+    parallelFor((unsigned int)subtrees.size(), 1,
+                [&](unsigned int first, unsigned int last) {
+                  BuildContext local = {boxes, refs.data(), false, nullptr};
+                  for (unsigned int i = first; i < last; ++i) {
+                    buildNode(local, subtrees[i].nodes, subtrees[i].range);
+                  }
+                });
+    for (Subtree &s : subtrees) {
+      int offset = (int)bvh.nodes.size();
+      for (BvhNode &node : s.nodes) {
+        for (int slot = 0; slot < 4; ++slot) {
+          if (node.count[slot] == 0 && node.child[slot] >= 0) {
+            node.child[slot] += offset;
+          }
+        }
+      }
+      bvh.nodes.insert(bvh.nodes.end(), s.nodes.begin(), s.nodes.end());
+      bvh.nodes[s.node].child[s.slot] = offset;
+    }
+  }
+
+  bvh.primitives.resize(count);
+  bvh.boxes.resize(count);
+  auto store = [&](unsigned int begin, unsigned int end) {
+    for (unsigned int i = begin; i < end; ++i) {
+      bvh.primitives[i] = refs[i].index;
+      bvh.boxes[i] = boxes[refs[i].index];
+    }
+  };
+  if (parallel) {
+    parallelFor(count, kRangeGrain, store);
+  } else {
+    store(0, count);
+  }
+}
+
+static inline const vec3 &vertex(const vec3 *vertices,
+                                 const unsigned int *indices, unsigned int i,
+                                 int k) {
+  return vertices[indices ? indices[i * 3 + k] : i * 3 + k];
+}
+
+static Aabb triangleBox(const vec3 *vertices, const unsigned int *indices,
+                        unsigned int i) {
+  Aabb box = {vertex(vertices, indices, i, 0), vertex(vertices, indices, i, 0)};
+  grow(box, vertex(vertices, indices, i, 1));
+  grow(box, vertex(vertices, indices, i, 2));
+  return box;
+}
+
+static std::vector<Aabb> triangleBoxes(const vec3 *vertices,
+                                       const unsigned int *indices,
+                                       unsigned int triangleCount) {
+  std::vector<Aabb> boxes(triangleCount);
+  for (unsigned int i = 0; i < triangleCount; ++i) {
+    boxes[i] = triangleBox(vertices, indices, i);
+  }
+  return boxes;
+}
+
+void buildBvh(Bvh &bvh, const Aabb *boxes, unsigned int count) {
+  build(bvh, boxes, count, false);
+}
+
+void buildBvh(Bvh &bvh, const vec3 *vertices, const unsigned int *indices,
+              unsigned int triangleCount) {
+  std::vector<Aabb> boxes = triangleBoxes(vertices, indices, triangleCount);
+  build(bvh, boxes.data(), triangleCount, false);
+}
+
+void buildBvhParallel(Bvh &bvh, const Aabb *boxes, unsigned int count) {
+  build(bvh, boxes, count, true);
+}
+
+void buildBvhParallel(Bvh &bvh, const vec3 *vertices,
+                      const unsigned int *indices, unsigned int triangleCount) {
+  std::vector<Aabb> boxes = triangleBoxes(vertices, indices, triangleCount);
+  build(bvh, boxes.data(), triangleCount, true);
+}
+
+// Replaces the leaf boxes with boxOf(primitive index), then refits the nodes
+// from the last to the root; children come after their parents, so each
+// node's children are final by the time it is reached.
+template <typename F> static void refit(Bvh &bvh, const F &boxOf) {
+  parallelFor((unsigned int)bvh.boxes.size(), kRefitGrain,
+              [&](unsigned int begin, unsigned int end) {
+                for (unsigned int i = begin; i < end; ++i) {
+                  bvh.boxes[i] = boxOf(bvh.primitives[i]);
+                }
+              });
+  for (size_t i = bvh.nodes.size(); i-- > 0;) {
+    BvhNode &node = bvh.nodes[i];
+    for (int slot = 0; slot < 4; ++slot) {
+      if (node.count[slot] > 0) {
+        const Aabb *boxes = &bvh.boxes[node.child[slot]];
+        Aabb box = boxes[0];
+        for (unsigned int k = 1; k < node.count[slot]; ++k) {
+          grow(box, boxes[k]);
+        }
+        setSlot(node, slot, box);
+      } else if (node.child[slot] >= 0) {
+        const BvhNode &child = bvh.nodes[node.child[slot]];
+        node.minX[slot] = minLane(f4Load(child.minX));
+        node.minY[slot] = minLane(f4Load(child.minY));
+        node.minZ[slot] = minLane(f4Load(child.minZ));
+        node.maxX[slot] = maxLane(f4Load(child.maxX));
+        node.maxY[slot] = maxLane(f4Load(child.maxY));
+        node.maxZ[slot] = maxLane(f4Load(child.maxZ));
+      }
+    }
+  }
+}
+
+void refitBvh(Bvh &bvh, const Aabb *boxes) {
+  refit(bvh, [&](unsigned int p) { return boxes[p]; });
+}
+
+void refitBvh(Bvh &bvh, const vec3 *vertices, const unsigned int *indices) {
+  refit(bvh,
+        [&](unsigned int p) { return triangleBox(vertices, indices, p); });
+}
+
+void refitBvh(Bvh &bvh, const Aabb *localBoxes, const mat4 *transforms) {
+  refit(bvh, [&](unsigned int p) {
+    return transformAabb(transforms[p], localBoxes[p]);
+  });
+}
+
+void refitBvh(Bvh &bvh, const Aabb *localBoxes, const Transform *transforms) {
+  refit(bvh, [&](unsigned int p) {
+    return transformAabb(transforms[p], localBoxes[p]);
+  });
+}
+
+// Visits the nodes the ray enters, nearest first, and hands every leaf it
+// enters before the current hit to testLeaf(first, count, hit).
+template <typename F>
+static RayHit traverseRay(const Bvh &bvh, const Ray &ray, float maxT,
+                          const F &testLeaf) {
+  RayHit hit = {maxT, 0.0f, 0.0f, RAY_NO_HIT};
+  if (bvh.nodes.empty()) {
+    return hit;
+  }
+  RayX4 r = makeRayX4(splat(ray.origin), splat(ray.direction));
+  TraversalStack stack;
+  stack.push({0, 0.0f});
+  StackEntry e;
+  while (stack.pop(e)) {
+    if (!(e.key < hit.t)) {
+      continue;
+    }
+    const BvhNode &node = bvh.nodes[e.node];
+    f4 t, u, v;
+    int bits = f4MaskBits(intersectX4(r, loadNodeX4(node), f4Splat(hit.t), t,
+                                      u, v));
+    if (!bits) {
+      continue;
+    }
+    float entry[4];
+    f4Store(entry, t);
+    StackEntry children[4];
+    int n = 0;
+    for (int slot = 0; slot < 4; ++slot) {
+      if (!(bits >> slot & 1) || !(entry[slot] < hit.t)) {
+        continue;
+      }
+      if (node.count[slot] > 0) {
+        testLeaf((unsigned int)node.child[slot], node.count[slot], hit);
+      } else if (node.child[slot] >= 0) {
+        children[n++] = {node.child[slot], entry[slot]};
+      }
+    }
+    stack.pushSorted(children, n);
+  }
+  return hit;
+}
+
+RayHit intersectBvh(const Bvh &bvh, const Ray &ray, float maxT) {
+  return traverseRay(
+      bvh, ray, maxT,
+      [&](unsigned int first, unsigned int count, RayHit &hit) {
+        for (unsigned int i = first; i < first + count; ++i) {
+          float t;
+          if (intersectAabb(ray, bvh.boxes[i], hit.t, t)) {
+            hit = {t, 0.0f, 0.0f, bvh.primitives[i]};
+          }
+        }
+      });
+}
+
+RayHit intersectBvh(const Bvh &bvh, const Ray &ray, const vec3 *vertices,
+                    const unsigned int *indices, float maxT) {
+  return traverseRay(
+      bvh, ray, maxT,
+      [&](unsigned int first, unsigned int count, RayHit &hit) {
+        for (unsigned int i = first; i < first + count; ++i) {
+          unsigned int p = bvh.primitives[i];
+          RayHit h = {0.0f, 0.0f, 0.0f, p};
+          if (intersectTriangle(ray, vertex(vertices, indices, p, 0),
+                                vertex(vertices, indices, p, 1),
+                                vertex(vertices, indices, p, 2), hit.t, h.t,
+                                h.u, h.v)) {
+            hit = h;
+          }
+        }
+      });
+}
+
+static bool overlaps(const Aabb &a, const Aabb &b) {
+  return !(a.max.x < b.min.x || b.max.x < a.min.x || a.max.y < b.min.y ||
+           b.max.y < a.min.y || a.max.z < b.min.z || b.max.z < a.min.z);
+}
+
+unsigned int overlapBvh(const Bvh &bvh, const Aabb &box, unsigned int *out,
+                        unsigned int capacity) {
+  unsigned int found = 0;
+  if (bvh.nodes.empty()) {
+    return found;
+  }
+  AabbX4 q = {splat(box.min), splat(box.max)};
+  TraversalStack stack;
+  stack.push({0, 0.0f});
+  StackEntry e;
+  while (stack.pop(e)) {
+    const BvhNode &node = bvh.nodes[e.node];
+    AabbX4 c = loadNodeX4(node);
+    f4 apartX = f4Or(f4Less(q.max.x, c.min.x), f4Less(c.max.x, q.min.x));
+    f4 apartY = f4Or(f4Less(q.max.y, c.min.y), f4Less(c.max.y, q.min.y));
+    f4 apartZ = f4Or(f4Less(q.max.z, c.min.z), f4Less(c.max.z, q.min.z));
+    f4 apart = f4Or(apartX, f4Or(apartY, apartZ));
+    int bits = ~f4MaskBits(apart) & 0xF;
+    for (int slot = 0; slot < 4; ++slot) {
+      if (!(bits >> slot & 1)) {
+        continue;
+      }
+      if (node.count[slot] > 0) {
+        unsigned int first = (unsigned int)node.child[slot];
+        for (unsigned int i = first; i < first + node.count[slot]; ++i) {
+          if (overlaps(box, bvh.boxes[i])) {
+            if (found < capacity) {
+              out[found] = bvh.primitives[i];
+            }
+            ++found;
+          }
+        }
+      } else if (node.child[slot] >= 0) {
+        stack.push({node.child[slot], 0.0f});
+      }
+    }
+  }
+  return found;
+}
+
+// Real-Time Collision Detection 5.1.5: the closest point by the Voronoi
+// region of the triangle that p falls in.
+vec3 closestPointOnTriangle(const vec3 &p, const vec3 &a, const vec3 &b,
+                            const vec3 &c) {
+  vec3 ab = b - a, ac = c - a, ap = p - a;
+  float d1 = dot(ab, ap), d2 = dot(ac, ap);
+  if (d1 <= 0.0f && d2 <= 0.0f) {
+    return a;
+  }
+  vec3 bp = p - b;
+  float d3 = dot(ab, bp), d4 = dot(ac, bp);
+  if (d3 >= 0.0f && d4 <= d3) {
+    return b;
+  }
+  float vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+    return a + ab * (d1 / (d1 - d3));
+  }
+  vec3 cp = p - c;
+  float d5 = dot(ab, cp), d6 = dot(ac, cp);
+  if (d6 >= 0.0f && d5 <= d6) {
+    return c;
+  }
+  float vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+    return a + ac * (d2 / (d2 - d6));
+  }
+  float va = d3 * d6 - d5 * d4;
+  if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+    return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+  }
+  float denom = 1.0f / (va + vb + vc);
+  return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+// Visits the nodes closer than the current best, nearest first, and hands
+// every such leaf to testLeaf(first, count, best).
+template <typename F>
+static BvhNearest traverseNearest(const Bvh &bvh, const vec3 &point,
+                                  float maxDistance, const F &testLeaf) {
+  BvhNearest best = {vec3(), maxDistance * maxDistance, RAY_NO_HIT};
+  if (bvh.nodes.empty()) {
+    return best;
+  }
+  vec3X4 p = splat(point);
+  f4 zero = f4Splat(0.0f);
+  TraversalStack stack;
+  stack.push({0, 0.0f});
+  StackEntry e;
+  while (stack.pop(e)) {
+    if (!(e.key < best.distanceSq)) {
+      continue;
+    }
+    const BvhNode &node = bvh.nodes[e.node];
+    AabbX4 c = loadNodeX4(node);
+    vec3X4 d = {f4Max(f4Max(f4Sub(c.min.x, p.x), f4Sub(p.x, c.max.x)), zero),
+                f4Max(f4Max(f4Sub(c.min.y, p.y), f4Sub(p.y, c.max.y)), zero),
+                f4Max(f4Max(f4Sub(c.min.z, p.z), f4Sub(p.z, c.max.z)), zero)};
+    float distSq[4];
+    f4Store(distSq, dot(d, d));
+    StackEntry children[4];
+    int n = 0;
+    for (int slot = 0; slot < 4; ++slot) {
+      if (!(distSq[slot] < best.distanceSq)) {
+        continue;
+      }
+      if (node.count[slot] > 0) {
+        testLeaf((unsigned int)node.child[slot], node.count[slot], best);
+      } else if (node.child[slot] >= 0) {
+        children[n++] = {node.child[slot], distSq[slot]};
+      }
+    }
+    stack.pushSorted(children, n);
+  }
+  return best;
+}
+
+BvhNearest nearestBvh(const Bvh &bvh, const vec3 &point, float maxDistance) {
+  return traverseNearest(
+      bvh, point, maxDistance,
+      [&](unsigned int first, unsigned int count, BvhNearest &best) {
+        for (unsigned int i = first; i < first + count; ++i) {
+          const Aabb &b = bvh.boxes[i];
+          vec3 q(fminf(fmaxf(point.x, b.min.x), b.max.x),
+                 fminf(fmaxf(point.y, b.min.y), b.max.y),
+                 fminf(fmaxf(point.z, b.min.z), b.max.z));
+          float distSq = lenSq(q - point);
+          if (distSq < best.distanceSq) {
+            best = {q, distSq, bvh.primitives[i]};
+          }
+        }
+      });
+}
+
+BvhNearest nearestBvh(const Bvh &bvh, const vec3 &point, const vec3 *vertices,
+                      const unsigned int *indices, float maxDistance) {
+  return traverseNearest(
+      bvh, point, maxDistance,
+      [&](unsigned int first, unsigned int count, BvhNearest &best) {
+        for (unsigned int i = first; i < first + count; ++i) {
+          unsigned int p = bvh.primitives[i];
+          vec3 q = closestPointOnTriangle(
+              point, vertex(vertices, indices, p, 0),
+              vertex(vertices, indices, p, 1), vertex(vertices, indices, p, 2));
+          float distSq = lenSq(q - point);
+          if (distSq < best.distanceSq) {
+            best = {q, distSq, p};
+          }
+        }
+      });
+}
@@ -0,0 +1,5 @@
+#pragma once
+// Runtime CPU feature detection for kernels built with ISA-specific flags.
+// Results are computed once and cached.
+
+bool cpuHasAvx2();
@@ -0,0 +1,192 @@
+#include "culling.h"
+#include "parallel.h"
+#include "simd.h"
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+static Plane makePlane(float a, float b, float c, float d) {
+  float invLen = 1.0f / sqrtf(a * a + b * b + c * c);
+  return {vec3(a * invLen, b * invLen, c * invLen), d * invLen};
+}
+
+Frustum extractFrustum(const mat4 &m) {
+  // Row r of the matrix is (v[r], v[4 + r], v[8 + r], v[12 + r])
+  Frustum f;
+  for (int i = 0; i < 3; ++i) {
+    f.planes[i * 2] = makePlane(m.v[3] + m.v[i], m.v[7] + m.v[4 + i],
+                                m.v[11] + m.v[8 + i], m.v[15] + m.v[12 + i]);
+    f.planes[i * 2 + 1] =
+        makePlane(m.v[3] - m.v[i], m.v[7] - m.v[4 + i], m.v[11] - m.v[8 + i],
+                  m.v[15] - m.v[12 + i]);
+  }
+  return f;
+}
+
+bool intersectsSphere(const Frustum &f, const vec3 &center, float radius) {
+  for (const Plane &p : f.planes) {
+    if (dot(p.normal, center) + p.distance < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool intersectsAabb(const Frustum &f, const vec3 &min, const vec3 &max) {
+  for (const Plane &p : f.planes) {
+    // The corner furthest along the normal
+    vec3 corner(p.normal.x >= 0.0f ? max.x : min.x,
+                p.normal.y >= 0.0f ? max.y : min.y,
+                p.normal.z >= 0.0f ? max.z : min.z);
+    if (dot(p.normal, corner) + p.distance < 0.0f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Appends base + lane for every bit set in mask. The stores are
+// unconditional; n never passes the index being written, so they stay
+// inside the visible range.
+static inline unsigned int compact(int mask, unsigned int base,
+                                   unsigned int *visible, unsigned int n) {
+  for (unsigned int lane = 0; lane < 4; ++lane) {
+    visible[n] = base + lane;
+    n += (mask >> lane) & 1;
+  }
+  return n;
+}
+
+static unsigned int cullSpheresRange(const Frustum &f, const Vec3SoA &c,
+                                     const float *radii, unsigned int begin,
+                                     unsigned int end, unsigned int *visible) {
+  f4 nx[6], ny[6], nz[6], d[6];
+  for (int p = 0; p < 6; ++p) {
+    nx[p] = f4Splat(f.planes[p].normal.x);
+    ny[p] = f4Splat(f.planes[p].normal.y);
+    nz[p] = f4Splat(f.planes[p].normal.z);
+    d[p] = f4Splat(f.planes[p].distance);
+  }
+  f4 zero = f4Splat(0.0f);
+
+  unsigned int n = 0;
+  unsigned int i = begin;
+  for (; i + 4 <= end; i += 4) {
+    f4 x = f4Load(c.x + i), y = f4Load(c.y + i), z = f4Load(c.z + i);
+    f4 r = f4Load(radii + i);
+    f4 outside = zero;
+    for (int p = 0; p < 6; ++p) {
+      f4 dist =
+          f4MulAdd(nx[p], x, f4MulAdd(ny[p], y, f4MulAdd(nz[p], z, d[p])));
+      outside = f4Or(outside, f4Less(f4Add(dist, r), zero));
+    }
+    n = compact(~f4MaskBits(outside) & 0xF, i, visible, n);
+  }
+  for (; i < end; ++i) {
+    if (intersectsSphere(f, vec3(c.x[i], c.y[i], c.z[i]), radii[i])) {
+      visible[n++] = i;
+    }
+  }
+  return n;
+}
+
+static unsigned int cullAabbsRange(const Frustum &f, const Vec3SoA &min,
+                                   const Vec3SoA &max, unsigned int begin,
+                                   unsigned int end, unsigned int *visible) {
+  // Pick the corner per plane once, so the lanes need no selects
+  f4 nx[6], ny[6], nz[6], d[6];
+  const float *px[6], *py[6], *pz[6];
+  for (int p = 0; p < 6; ++p) {
+    const Plane &plane = f.planes[p];
+    nx[p] = f4Splat(plane.normal.x);
+    ny[p] = f4Splat(plane.normal.y);
+    nz[p] = f4Splat(plane.normal.z);
+    d[p] = f4Splat(plane.distance);
+    px[p] = plane.normal.x >= 0.0f ? max.x : min.x;
+    py[p] = plane.normal.y >= 0.0f ? max.y : min.y;
+    pz[p] = plane.normal.z >= 0.0f ? max.z : min.z;
+  }
+  f4 zero = f4Splat(0.0f);
+
+  unsigned int n = 0;
+  unsigned int i = begin;
+  for (; i + 4 <= end; i += 4) {
+    f4 outside = zero;
+    for (int p = 0; p < 6; ++p) {
+      f4 dist = f4MulAdd(
+          nx[p], f4Load(px[p] + i),
+          f4MulAdd(ny[p], f4Load(py[p] + i),
+                   f4MulAdd(nz[p], f4Load(pz[p] + i), d[p])));
+      outside = f4Or(outside, f4Less(dist, zero));
+    }
+    n = compact(~f4MaskBits(outside) & 0xF, i, visible, n);
+  }
+  for (; i < end; ++i) {
+    if (intersectsAabb(f, vec3(min.x[i], min.y[i], min.z[i]),
+                       vec3(max.x[i], max.y[i], max.z[i]))) {
+      visible[n++] = i;
+    }
+  }
+  return n;
+}
+
+unsigned int cullSpheres(const Frustum &f, const Vec3SoA &centers,
+                         const float *radii, unsigned int count,
+                         unsigned int *visible) {
+  return cullSpheresRange(f, centers, radii, 0, count, visible);
+}
+
+unsigned int cullAabbs(const Frustum &f, const Vec3SoA &min, const Vec3SoA &max,
+                       unsigned int count, unsigned int *visible) {
+  return cullAabbsRange(f, min, max, 0, count, visible);
+}
+
+static const unsigned int kCullBlock = 8192;
+
+// Each block compacts into its own slice of visible, starting at its first
+// index, then the slices are moved down behind each other.
+template <typename F>
+static unsigned int cullBlocks(unsigned int count, unsigned int *visible,
+                               const F &cullRange) {
+  unsigned int blocks = (count + kCullBlock - 1) / kCullBlock;
+  if (blocks <= 1) {
+    return cullRange(0, count, visible);
+  }
+  std::vector<unsigned int> counts(blocks);
+  parallelFor(blocks, 1, [&](unsigned int first, unsigned int last) {
+    for (unsigned int b = first; b < last; ++b) {
+      unsigned int begin = b * kCullBlock;
+      unsigned int end =
+          count - begin < kCullBlock ? count : begin + kCullBlock;
+      counts[b] = cullRange(begin, end, visible + begin);
+    }
+  });
+  unsigned int n = counts[0];
+  for (unsigned int b = 1; b < blocks; ++b) {
+    memmove(visible + n, visible + b * kCullBlock,
+            counts[b] * sizeof(unsigned int));
+    n += counts[b];
+  }
+  return n;
+}
+
+unsigned int cullSpheresParallel(const Frustum &f, const Vec3SoA &centers,
+                                 const float *radii, unsigned int count,
+                                 unsigned int *visible) {
+  return cullBlocks(count, visible,
+                    [&](unsigned int begin, unsigned int end,
+                        unsigned int *out) {
+                      return cullSpheresRange(f, centers, radii, begin, end,
+                                              out);
+                    });
+}
+
+unsigned int cullAabbsParallel(const Frustum &f, const Vec3SoA &min,
+                               const Vec3SoA &max, unsigned int count,
+                               unsigned int *visible) {
+  return cullBlocks(count, visible,
+                    [&](unsigned int begin, unsigned int end,
+                        unsigned int *out) {
+                      return cullAabbsRange(f, min, max, begin, end, out);
+                    });
+}
@@ -0,0 +1,41 @@
+#include "diagnostics.h"
+#include <atomic>
+
+#ifdef MATHS_DIAGNOSTICS
+static std::atomic<unsigned long long> counters[(int)Diagnostic::Count];
+
+void countDiagnostic(Diagnostic counter) {
+  counters[(int)counter].fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+DiagnosticCounts readDiagnostics(bool reset) {
+  DiagnosticCounts result = {};
+#ifdef MATHS_DIAGNOSTICS
+  for (int i = 0; i < (int)Diagnostic::Count; ++i) {
+    result.counts[i] = reset
+                           ? counters[i].exchange(0, std::memory_order_relaxed)
+                           : counters[i].load(std::memory_order_relaxed);
+  }
+#else
+  (void)reset;
+#endif
+  return result;
+}
+
+const char *diagnosticName(Diagnostic counter) {
+  switch (counter) {
+  case Diagnostic::SingularInverse:
+    return "singularInverse";
+  case Diagnostic::SingularInverseAffine:
+    return "singularInverseAffine";
+  case Diagnostic::DegenerateFrustum:
+    return "degenerateFrustum";
+  case Diagnostic::DegenerateOrtho:
+    return "degenerateOrtho";
+  case Diagnostic::DegenerateLookAt:
+    return "degenerateLookAt";
+  default:
+    return "unknown";
+  }
+}
@@ -0,0 +1,96 @@
+#include "dualQuaternion.h"
+#include "parallel.h"
+#include "transformSimd.h"
+
+void transformToDualQuat(const Transform *in, DualQuaternion *out,
+                         unsigned int count) {
+  for (unsigned int i = 0; i < count; ++i) {
+    out[i] = transformToDualQuat(in[i]);
+  }
+}
+
+void dualQuatToTransform(const DualQuaternion *in, Transform *out,
+                         unsigned int count) {
+  for (unsigned int i = 0; i < count; ++i) {
+    out[i] = dualQuatToTransform(in[i]);
+  }
+}
+
+static const unsigned int kConvertGrain = 4096;
+
+void transformToDualQuatParallel(const Transform *in, DualQuaternion *out,
+                                 unsigned int count, unsigned int grain) {
+  parallelFor(count, grain ? grain : kConvertGrain,
+              [&](unsigned int begin, unsigned int end) {
+                transformToDualQuat(in + begin, out + begin, end - begin);
+              });
+}
+
+void dualQuatToTransformParallel(const DualQuaternion *in, Transform *out,
+                                 unsigned int count, unsigned int grain) {
+  parallelFor(count, grain ? grain : kConvertGrain,
+              [&](unsigned int begin, unsigned int end) {
+                dualQuatToTransform(in + begin, out + begin, end - begin);
+              });
+}
+
+void cacheDualQuat(const DualQuaternion *in, CachedDualQuaternion *out,
+                   unsigned int count) {
+  for (unsigned int i = 0; i < count; ++i) {
+    out[i] = cacheDualQuat(in[i]);
+  }
+}
+
+void transformPoints(const CachedDualQuaternion &dq, const vec3 *in, vec3 *out,
+                     unsigned int count) {
+  quatX4 q = {f4Splat(dq.real.x), f4Splat(dq.real.y), f4Splat(dq.real.z),
+              f4Splat(dq.real.w)};
+  vec3X4 t = {f4Splat(dq.translation.x), f4Splat(dq.translation.y),
+              f4Splat(dq.translation.z)};
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    vec3X4 p;
+    f4Load3(in[i].v, p.x, p.y, p.z);
+    p = q * p + t;
+    f4Store3(out[i].v, p.x, p.y, p.z);
+  }
+  for (; i < count; ++i) {
+    out[i] = transformPoint(dq, in[i]);
+  }
+}
+
+static inline void loadDualQuatX4(const DualQuaternion *dq, quatX4 &real,
+                                  quatX4 &dual) {
+  const float *const p[4] = {dq[0].v, dq[1].v, dq[2].v, dq[3].v};
+  loadTransposed(p, 0, real.x, real.y, real.z, real.w);
+  loadTransposed(p, 4, dual.x, dual.y, dual.z, dual.w);
+}
+
+void nlerp(const DualQuaternion *from, const DualQuaternion *to, float t,
+           DualQuaternion *out, unsigned int count) {
+  f4 a = f4Splat(1.0f - t);
+  f4 b = f4Splat(t);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    quatX4 fr, fd, tr, td;
+    loadDualQuatX4(from + i, fr, fd);
+    loadDualQuatX4(to + i, tr, td);
+    f4 w = f4MulSign(b, dot(fr, tr));
+    quatX4 real = fr * a + tr * w;
+    quatX4 dual = fd * a + td * w;
+    normalizeDualQuatX4(real, dual);
+    float *const p[4] = {out[i].v, out[i + 1].v, out[i + 2].v, out[i + 3].v};
+    storeTransposed(p, 0, real.x, real.y, real.z, real.w);
+    storeTransposed(p, 4, dual.x, dual.y, dual.z, dual.w);
+  }
+  for (; i < count; ++i) {
+    out[i] = nlerp(from[i], to[i], t);
+  }
+}
+
+void sclerp(const DualQuaternion *from, const DualQuaternion *to, float t,
+            DualQuaternion *out, unsigned int count) {
+  for (unsigned int i = 0; i < count; ++i) {
+    out[i] = sclerp(from[i], to[i], t);
+  }
+}
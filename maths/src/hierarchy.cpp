@@ -0,0 +1,193 @@
+#include "hierarchy.h"
+#include "parallel.h"
+#include "transformSimd.h"
+#include <vector>
+
+namespace {
+struct TransformOutput {
+  Transform *world;
+  inline void store(unsigned int i, const Transform &t) const { world[i] = t; }
+  inline void store(const unsigned int i[4], const TransformX4 &t) const {
+    storeTransformX4(t, world + i[0], world + i[1], world + i[2],
+                     world + i[3]);
+  }
+};
+
+struct MatrixOutput {
+  mat4 *world;
+  inline void store(unsigned int i, const Transform &t) const {
+    world[i] = transformToMat4(t);
+  }
+  inline void store(const unsigned int i[4], const TransformX4 &t) const {
+    storeMat4X4(t, world + i[0], world + i[1], world + i[2], world + i[3]);
+  }
+};
+} // namespace
+
+// World transforms are kept here when the output is matrices, and for the
+// lanes of the instanced path. Reused between calls on the same thread.
+static thread_local std::vector<Transform> transformScratch;
+static thread_local std::vector<TransformX4> laneScratch;
+
+template <typename Output>
+static void propagate(const Transform *local, const int *parents,
+                      Transform *world, const Output &out,
+                      unsigned int jointCount) {
+  for (unsigned int j = 0; j < jointCount; ++j) {
+    int p = parents[j];
+    world[j] = p < 0 ? local[j] : combine(world[p], local[j]);
+    out.store(j, world[j]);
+  }
+}
+
+// Instances [first, first + 4) in lanes. Lanes past the last instance repeat
+// it, so their stores write the same values twice.
+template <typename Output>
+static void propagateX4(const Transform *local, const int *parents,
+                        const Output &out, unsigned int jointCount,
+                        unsigned int first, unsigned int instanceCount) {
+  laneScratch.resize(jointCount);
+  TransformX4 *world = laneScratch.data();
+  unsigned int base[4];
+  for (unsigned int k = 0; k < 4; ++k) {
+    unsigned int instance = first + k < instanceCount ? first + k
+                                                      : instanceCount - 1;
+    base[k] = instance * jointCount;
+  }
+  for (unsigned int j = 0; j < jointCount; ++j) {
+    unsigned int i[4] = {base[0] + j, base[1] + j, base[2] + j, base[3] + j};
+    TransformX4 l = loadTransformX4(local + i[0], local + i[1], local + i[2],
+                                    local + i[3]);
+    int p = parents[j];
+    world[j] = p < 0 ? l : combine(world[p], l);
+    out.store(i, world[j]);
+  }
+}
+
+template <typename Output>
+static void propagateInstances(const Transform *local, const int *parents,
+                               const Output &out, unsigned int jointCount,
+                               unsigned int firstGroup, unsigned int endGroup,
+                               unsigned int instanceCount) {
+  for (unsigned int g = firstGroup; g < endGroup; ++g) {
+    propagateX4(local, parents, out, jointCount, g * 4, instanceCount);
+  }
+}
+
+void computeWorldTransforms(const Transform *local, const int *parents,
+                            Transform *world, unsigned int jointCount) {
+  propagate(local, parents, world, TransformOutput{world}, jointCount);
+}
+
+void computeWorldMatrices(const Transform *local, const int *parents,
+                          mat4 *world, unsigned int jointCount) {
+  transformScratch.resize(jointCount);
+  propagate(local, parents, transformScratch.data(), MatrixOutput{world},
+            jointCount);
+}
+
+void computeWorldTransforms(const Transform *local, const int *parents,
+                            Transform *world, unsigned int jointCount,
+                            unsigned int instanceCount) {
+  if (instanceCount == 1) {
+    computeWorldTransforms(local, parents, world, jointCount);
+    return;
+  }
+  propagateInstances(local, parents, TransformOutput{world}, jointCount, 0,
+                     (instanceCount + 3) / 4, instanceCount);
+}
+
+void computeWorldMatrices(const Transform *local, const int *parents,
+                          mat4 *world, unsigned int jointCount,
+                          unsigned int instanceCount) {
+  if (instanceCount == 1) {
+    computeWorldMatrices(local, parents, world, jointCount);
+    return;
+  }
+  propagateInstances(local, parents, MatrixOutput{world}, jointCount, 0,
+                     (instanceCount + 3) / 4, instanceCount);
+}
+
+// Joints sorted by depth; levels[d] is where depth d starts in order.
+static void sortByDepth(const int *parents, unsigned int jointCount,
+                        std::vector<unsigned int> &order,
+                        std::vector<unsigned int> &levels) {
+  std::vector<unsigned int> depth(jointCount);
+  unsigned int maxDepth = 0;
+  for (unsigned int j = 0; j < jointCount; ++j) {
+    depth[j] = parents[j] < 0 ? 0 : depth[parents[j]] + 1;
+    maxDepth = depth[j] > maxDepth ? depth[j] : maxDepth;
+  }
+  levels.assign(maxDepth + 2, 0);
+  for (unsigned int j = 0; j < jointCount; ++j) {
+    ++levels[depth[j] + 1];
+  }
+  for (unsigned int d = 1; d < levels.size(); ++d) {
+    levels[d] += levels[d - 1];
+  }
+  std::vector<unsigned int> cursor(levels.begin(), levels.end() - 1);
+  order.resize(jointCount);
+  for (unsigned int j = 0; j < jointCount; ++j) {
+    order[cursor[depth[j]]++] = j;
+  }
+}
+
+// Every joint of one level only depends on the levels above it, so each level
+// is a parallel pass.
+template <typename Output>
+static void propagateLevels(const Transform *local, const int *parents,
+                            Transform *world, const Output &out,
+                            unsigned int jointCount) {
+  std::vector<unsigned int> order;
+  std::vector<unsigned int> levels;
+  sortByDepth(parents, jointCount, order, levels);
+  for (unsigned int d = 0; d + 1 < levels.size(); ++d) {
+    const unsigned int *joints = order.data() + levels[d];
+    parallelFor(levels[d + 1] - levels[d], 1024,
+                [&](unsigned int begin, unsigned int end) {
+                  for (unsigned int i = begin; i < end; ++i) {
+                    unsigned int j = joints[i];
+                    int p = parents[j];
+                    world[j] = p < 0 ? local[j] : combine(world[p], local[j]);
+                    out.store(j, world[j]);
+                  }
+                });
+  }
+}
+
+template <typename Output>
+static void propagateParallel(const Transform *local, const int *parents,
+                              const Output &out, unsigned int jointCount,
+                              unsigned int instanceCount) {
+  unsigned int groups = (instanceCount + 3) / 4;
+  // Aim for roughly 4k joints per task
+  unsigned int grain = 4096 / (jointCount * 4 + 1) + 1;
+  parallelFor(groups, grain, [&](unsigned int begin, unsigned int end) {
+    propagateInstances(local, parents, out, jointCount, begin, end,
+                       instanceCount);
+  });
+}
+
+void computeWorldTransformsParallel(const Transform *local, const int *parents,
+                                    Transform *world, unsigned int jointCount,
+                                    unsigned int instanceCount) {
+  if (instanceCount == 1) {
+    propagateLevels(local, parents, world, TransformOutput{world}, jointCount);
+    return;
+  }
+  propagateParallel(local, parents, TransformOutput{world}, jointCount,
+                    instanceCount);
+}
+
+void computeWorldMatricesParallel(const Transform *local, const int *parents,
+                                  mat4 *world, unsigned int jointCount,
+                                  unsigned int instanceCount) {
+  if (instanceCount == 1) {
+    std::vector<Transform> transforms(jointCount);
+    propagateLevels(local, parents, transforms.data(), MatrixOutput{world},
+                    jointCount);
+    return;
+  }
+  propagateParallel(local, parents, MatrixOutput{world}, jointCount,
+                    instanceCount);
+}
@@ -0,0 +1,254 @@
+#include "integration.h"
+#include "parallel.h"
+#include "transformSimd.h"
+#include <math.h>
+
+static const unsigned int kIntegrateGrain = 8192;
+
+// Taylor series in x = a * a of sin(a) / a and cos(a), highest power first.
+// Both are within float precision for a up to pi / 2, where x is below
+// kSeriesLimit; larger half angles use sinf and cosf.
+static const float kSinc[6] = {-1.0f / 39916800, 1.0f / 362880, -1.0f / 5040,
+                               1.0f / 120,       -1.0f / 6,     1.0f};
+static const float kCos[7] = {1.0f / 479001600, -1.0f / 3628800,
+                              1.0f / 40320,     -1.0f / 720,
+                              1.0f / 24,        -1.0f / 2,
+                              1.0f};
+static const float kSeriesLimit = 2.4674011f;
+
+// The step is c * q + s * q * quat(w, 0): c = 1 and s = dt / 2 for the first
+// order step, and for the exponential map the cosine of the half angle and
+// its sine over |w|.
+static void expCoefficients(float h, float x, float &c, float &s) {
+  if (x <= kSeriesLimit) {
+    float sinc = kSinc[0];
+    for (int i = 1; i < 6; ++i) {
+      sinc = sinc * x + kSinc[i];
+    }
+    float cosine = kCos[0];
+    for (int i = 1; i < 7; ++i) {
+      cosine = cosine * x + kCos[i];
+    }
+    c = cosine;
+    s = h * sinc;
+  } else {
+    float a = sqrtf(x);
+    c = cosf(a);
+    s = h * sinf(a) / a;
+  }
+}
+
+template <bool Exp>
+static quat step(const quat &q, const vec3 &w, float h) {
+  float c = 1.0f, s = h;
+  if (Exp) {
+    expCoefficients(h, h * h * (w.x * w.x + w.y * w.y + w.z * w.z), c, s);
+  }
+  float x = c * q.x + s * (w.x * q.w + w.y * q.z - w.z * q.y);
+  float y = c * q.y + s * (w.y * q.w + w.z * q.x - w.x * q.z);
+  float z = c * q.z + s * (w.z * q.w + w.x * q.y - w.y * q.x);
+  float r = c * q.w - s * (w.x * q.x + w.y * q.y + w.z * q.z);
+  float lenSq = x * x + y * y + z * z + r * r;
+  float invLen = lenSq < QUAT_EPSILON ? 1.0f : 1.0f / sqrtf(lenSq);
+  return quat(x * invLen, y * invLen, z * invLen, r * invLen);
+}
+
+template <bool Exp>
+static quatX4 stepX4(const quatX4 &q, const vec3X4 &w, f4 h) {
+  f4 one = f4Splat(1.0f);
+  f4 c = one, s = h;
+  if (Exp) {
+    f4 x = f4Mul(f4Mul(h, h), dot(w, w));
+    f4 sinc = f4Splat(kSinc[0]);
+    for (int i = 1; i < 6; ++i) {
+      sinc = f4MulAdd(sinc, x, f4Splat(kSinc[i]));
+    }
+    c = f4Splat(kCos[0]);
+    for (int i = 1; i < 7; ++i) {
+      c = f4MulAdd(c, x, f4Splat(kCos[i]));
+    }
+    s = f4Mul(h, sinc);
+    f4 large = f4Less(f4Splat(kSeriesLimit), x);
+    if (f4MaskBits(large)) {
+      float xs[4], cs[4], ss[4];
+      f4Store(xs, x);
+      f4Store(cs, c);
+      f4Store(ss, s);
+      float hs = f4First(h);
+      for (int i = 0; i < 4; ++i) {
+        expCoefficients(hs, xs[i], cs[i], ss[i]);
+      }
+      c = f4Load(cs);
+      s = f4Load(ss);
+    }
+  }
+  quatX4 spin;
+  spin.x = f4Sub(f4MulAdd(w.x, q.w, f4Mul(w.y, q.z)), f4Mul(w.z, q.y));
+  spin.y = f4Sub(f4MulAdd(w.y, q.w, f4Mul(w.z, q.x)), f4Mul(w.x, q.z));
+  spin.z = f4Sub(f4MulAdd(w.z, q.w, f4Mul(w.x, q.y)), f4Mul(w.y, q.x));
+  spin.w = f4Sub(f4Splat(0.0f), dot(w, vec3X4{q.x, q.y, q.z}));
+  quatX4 r = q * c + spin * s;
+  f4 lenSq = dot(r, r);
+  f4 invLen = f4Div(one, f4Sqrt(lenSq));
+  invLen = f4Select(f4Less(lenSq, f4Splat(QUAT_EPSILON)), one, invLen);
+  return r * invLen;
+}
+
+template <bool Exp>
+static void integrate(quat *q, const vec3 *w, float dt, unsigned int count) {
+  float h = dt * 0.5f;
+  f4 h4 = f4Splat(h);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    vec3X4 w4;
+    f4Load3(w[i].v, w4.x, w4.y, w4.z);
+    storeQuatX4(stepX4<Exp>(loadQuatX4(q + i), w4, h4), q + i);
+  }
+  for (; i < count; ++i) {
+    q[i] = step<Exp>(q[i], w[i], h);
+  }
+}
+
+template <bool Exp>
+static void integrate(const QuatSoA &q, const Vec3SoA &w, float dt,
+                      unsigned int count) {
+  float h = dt * 0.5f;
+  f4 h4 = f4Splat(h);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    quatX4 q4 = {f4Load(q.x + i), f4Load(q.y + i), f4Load(q.z + i),
+                 f4Load(q.w + i)};
+    vec3X4 w4 = {f4Load(w.x + i), f4Load(w.y + i), f4Load(w.z + i)};
+    q4 = stepX4<Exp>(q4, w4, h4);
+    f4Store(q.x + i, q4.x);
+    f4Store(q.y + i, q4.y);
+    f4Store(q.z + i, q4.z);
+    f4Store(q.w + i, q4.w);
+  }
+  for (; i < count; ++i) {
+    quat r = step<Exp>(quat(q.x[i], q.y[i], q.z[i], q.w[i]),
+                       vec3(w.x[i], w.y[i], w.z[i]), h);
+    q.x[i] = r.x;
+    q.y[i] = r.y;
+    q.z[i] = r.z;
+    q.w[i] = r.w;
+  }
+}
+
+// p += v * dt over count floats
+static void addScaled(float *p, const float *v, float dt, unsigned int count) {
+  f4 dt4 = f4Splat(dt);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    f4Store(p + i, f4MulAdd(f4Load(v + i), dt4, f4Load(p + i)));
+  }
+  for (; i < count; ++i) {
+    p[i] += v[i] * dt;
+  }
+}
+
+void integrateOrientations(quat *orientations, const vec3 *angularVelocities,
+                           float dt, unsigned int count) {
+  integrate<false>(orientations, angularVelocities, dt, count);
+}
+
+void integrateOrientations(const QuatSoA &orientations,
+                           const Vec3SoA &angularVelocities, float dt,
+                           unsigned int count) {
+  integrate<false>(orientations, angularVelocities, dt, count);
+}
+
+void integrateOrientationsExp(quat *orientations,
+                              const vec3 *angularVelocities, float dt,
+                              unsigned int count) {
+  integrate<true>(orientations, angularVelocities, dt, count);
+}
+
+void integrateOrientationsExp(const QuatSoA &orientations,
+                              const Vec3SoA &angularVelocities, float dt,
+                              unsigned int count) {
+  integrate<true>(orientations, angularVelocities, dt, count);
+}
+
+void integratePositions(vec3 *positions, const vec3 *velocities, float dt,
+                        unsigned int count) {
+  addScaled((float *)positions, (const float *)velocities, dt, count * 3);
+}
+
+void integratePositions(const Vec3SoA &positions, const Vec3SoA &velocities,
+                        float dt, unsigned int count) {
+  addScaled(positions.x, velocities.x, dt, count);
+  addScaled(positions.y, velocities.y, dt, count);
+  addScaled(positions.z, velocities.z, dt, count);
+}
+
+static QuatSoA offset(const QuatSoA &q, unsigned int begin) {
+  return QuatSoA{q.x + begin, q.y + begin, q.z + begin, q.w + begin};
+}
+
+static Vec3SoA offset(const Vec3SoA &v, unsigned int begin) {
+  return Vec3SoA{v.x + begin, v.y + begin, v.z + begin};
+}
+
+void integrateOrientationsParallel(quat *orientations,
+                                   const vec3 *angularVelocities, float dt,
+                                   unsigned int count, unsigned int grain) {
+  parallelFor(count, grain ? grain : kIntegrateGrain,
+              [&](unsigned int begin, unsigned int end) {
+                integrate<false>(orientations + begin,
+                                 angularVelocities + begin, dt, end - begin);
+              });
+}
+
+void integrateOrientationsParallel(const QuatSoA &orientations,
+                                   const Vec3SoA &angularVelocities, float dt,
+                                   unsigned int count, unsigned int grain) {
+  parallelFor(count, grain ? grain : kIntegrateGrain,
+              [&](unsigned int begin, unsigned int end) {
+                integrate<false>(offset(orientations, begin),
+                                 offset(angularVelocities, begin), dt,
+                                 end - begin);
+              });
+}
+
+void integrateOrientationsExpParallel(quat *orientations,
+                                      const vec3 *angularVelocities, float dt,
+                                      unsigned int count, unsigned int grain) {
+  parallelFor(count, grain ? grain : kIntegrateGrain,
+              [&](unsigned int begin, unsigned int end) {
+                integrate<true>(orientations + begin,
+                                angularVelocities + begin, dt, end - begin);
+              });
+}
+
+void integrateOrientationsExpParallel(const QuatSoA &orientations,
+                                      const Vec3SoA &angularVelocities,
+                                      float dt, unsigned int count,
+                                      unsigned int grain) {
+  parallelFor(count, grain ? grain : kIntegrateGrain,
+              [&](unsigned int begin, unsigned int end) {
+                integrate<true>(offset(orientations, begin),
+                                offset(angularVelocities, begin), dt,
+                                end - begin);
+              });
+}
+
+void integratePositionsParallel(vec3 *positions, const vec3 *velocities,
+                                float dt, unsigned int count,
+                                unsigned int grain) {
+  parallelFor(count, grain ? grain : kIntegrateGrain,
+              [&](unsigned int begin, unsigned int end) {
+                integratePositions(positions + begin, velocities + begin, dt,
+                                   end - begin);
+              });
+}
+
+void integratePositionsParallel(const Vec3SoA &positions,
+                                const Vec3SoA &velocities, float dt,
+                                unsigned int count, unsigned int grain) {
+  parallelFor(count, grain ? grain : kIntegrateGrain,
+              [&](unsigned int begin, unsigned int end) {
+                integratePositions(offset(positions, begin),
+                                   offset(velocities, begin), dt, end - begin);
+              });
+}
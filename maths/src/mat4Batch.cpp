@@ -0,0 +1,212 @@
+#include "avx2.h"
+#include "cpu.h"
+#include "mat4.h"
+#include "mat4Kernels.h"
+#include "parallel.h"
+#include "simd.h"
+
+namespace {
+struct Columns {
+  f4 c[16];
+  inline Columns(const float *m) {
+    for (int i = 0; i < 16; ++i) {
+      c[i] = f4Splat(m[i]);
+    }
+  }
+};
+} // namespace
+
+static inline f4 row(const Columns &m, int r, f4 x, f4 y, f4 z, f4 w) {
+  return f4MulAdd(m.c[0 + r], x,
+                  f4MulAdd(m.c[4 + r], y,
+                           f4MulAdd(m.c[8 + r], z, f4Mul(m.c[12 + r], w))));
+}
+
+static inline void transformOne(const float *m, float x, float y, float z,
+                                float *w, float translate, float *out) {
+  float _w = w ? *w : translate;
+  out[0] = m[0] * x + m[4] * y + m[8] * z + m[12] * _w;
+  out[1] = m[1] * x + m[5] * y + m[9] * z + m[13] * _w;
+  out[2] = m[2] * x + m[6] * y + m[10] * z + m[14] * _w;
+  if (w) {
+    *w = m[3] * x + m[7] * y + m[11] * z + m[15] * _w;
+  }
+}
+
+static void transformAos(const float *m, const float *in, float *out,
+                         float *w, float translate, unsigned int count) {
+#ifdef MATHS_AVX2
+  if (cpuHasAvx2()) {
+    transformAosAvx2(m, in, out, w, translate, count);
+    return;
+  }
+#endif
+  Columns cols(m);
+  f4 t = f4Splat(translate);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    f4 x, y, z;
+    f4Load3(in + i * 3, x, y, z);
+    f4 _w = w ? f4Load(w + i) : t;
+    f4Store3(out + i * 3, row(cols, 0, x, y, z, _w), row(cols, 1, x, y, z, _w),
+             row(cols, 2, x, y, z, _w));
+    if (w) {
+      f4Store(w + i, row(cols, 3, x, y, z, _w));
+    }
+  }
+  for (; i < count; ++i) {
+    const float *p = in + i * 3;
+    transformOne(m, p[0], p[1], p[2], w ? w + i : nullptr, translate,
+                 out + i * 3);
+  }
+}
+
+static void transformSoa(const float *m, const Vec3SoA &in, const Vec3SoA &out,
+                         float *w, float translate, unsigned int count) {
+#ifdef MATHS_AVX2
+  if (cpuHasAvx2()) {
+    transformSoaAvx2(m, in.x, in.y, in.z, out.x, out.y, out.z, w, translate,
+                     count);
+    return;
+  }
+#endif
+  Columns cols(m);
+  f4 t = f4Splat(translate);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    f4 x = f4Load(in.x + i);
+    f4 y = f4Load(in.y + i);
+    f4 z = f4Load(in.z + i);
+    f4 _w = w ? f4Load(w + i) : t;
+    f4Store(out.x + i, row(cols, 0, x, y, z, _w));
+    f4Store(out.y + i, row(cols, 1, x, y, z, _w));
+    f4Store(out.z + i, row(cols, 2, x, y, z, _w));
+    if (w) {
+      f4Store(w + i, row(cols, 3, x, y, z, _w));
+    }
+  }
+  for (; i < count; ++i) {
+    float r[3];
+    transformOne(m, in.x[i], in.y[i], in.z[i], w ? w + i : nullptr, translate,
+                 r);
+    out.x[i] = r[0];
+    out.y[i] = r[1];
+    out.z[i] = r[2];
+  }
+}
+
+void transformVectors(const mat4 &m, const vec3 *in, vec3 *out,
+                      unsigned int count) {
+  transformAos(m.v, (const float *)in, (float *)out, nullptr, 0.0f, count);
+}
+
+void transformPoints(const mat4 &m, const vec3 *in, vec3 *out,
+                     unsigned int count) {
+  transformAos(m.v, (const float *)in, (float *)out, nullptr, 1.0f, count);
+}
+
+void transformPoints(const mat4 &m, const vec3 *in, vec3 *out, float *w,
+                     unsigned int count) {
+  transformAos(m.v, (const float *)in, (float *)out, w, 1.0f, count);
+}
+
+void transformVectors(const mat4 &m, const Vec3SoA &in, const Vec3SoA &out,
+                      unsigned int count) {
+  transformSoa(m.v, in, out, nullptr, 0.0f, count);
+}
+
+void transformPoints(const mat4 &m, const Vec3SoA &in, const Vec3SoA &out,
+                     unsigned int count) {
+  transformSoa(m.v, in, out, nullptr, 1.0f, count);
+}
+
+void transformPoints(const mat4 &m, const Vec3SoA &in, const Vec3SoA &out,
+                     float *w, unsigned int count) {
+  transformSoa(m.v, in, out, w, 1.0f, count);
+}
+
+static const unsigned int kTransformGrain = 8192;
+
+void transformVectorsParallel(const mat4 &m, const vec3 *in, vec3 *out,
+                              unsigned int count, unsigned int grain) {
+  parallelFor(count, grain ? grain : kTransformGrain,
+              [&](unsigned int begin, unsigned int end) {
+                transformVectors(m, in + begin, out + begin, end - begin);
+              });
+}
+
+void transformPointsParallel(const mat4 &m, const vec3 *in, vec3 *out,
+                             unsigned int count, unsigned int grain) {
+  parallelFor(count, grain ? grain : kTransformGrain,
+              [&](unsigned int begin, unsigned int end) {
+                transformPoints(m, in + begin, out + begin, end - begin);
+              });
+}
+
+void transformPointsParallel(const mat4 &m, const Vec3SoA &in,
+                             const Vec3SoA &out, unsigned int count,
+                             unsigned int grain) {
+  parallelFor(count, grain ? grain : kTransformGrain,
+              [&](unsigned int begin, unsigned int end) {
+                transformPoints(
+                    m, Vec3SoA{in.x + begin, in.y + begin, in.z + begin},
+                    Vec3SoA{out.x + begin, out.y + begin, out.z + begin},
+                    end - begin);
+              });
+}
+
+unsigned int inverse(const mat4 *in, mat4 *out, unsigned int count) {
+  const Mat4Kernels &kernels = mat4Kernels();
+  unsigned int singular = 0;
+  for (unsigned int i = 0; i < count; ++i) {
+    if (kernels.inverse(in[i].v, out[i].v) == 0.0f) {
+      MATHS_COUNT(Diagnostic::SingularInverse);
+      out[i] = mat4();
+      ++singular;
+    }
+  }
+  return singular;
+}
+
+unsigned int inverseAffine(const mat4 *in, mat4 *out, unsigned int count) {
+  unsigned int singular = 0;
+  for (unsigned int i = 0; i < count; ++i) {
+    if (!tryInverseAffine(in[i], out[i])) {
+      out[i] = mat4();
+      ++singular;
+    }
+  }
+  return singular;
+}
+
+void inverseRigid(const mat4 *in, mat4 *out, unsigned int count) {
+  for (unsigned int i = 0; i < count; ++i) {
+    out[i] = inverseRigid(in[i]);
+  }
+}
+
+unsigned int inverseAuto(const mat4 *in, mat4 *out, unsigned int count) {
+  const Mat4Kernels &kernels = mat4Kernels();
+  unsigned int singular = 0;
+  for (unsigned int i = 0; i < count; ++i) {
+    switch (classify(in[i])) {
+    case Mat4Class::Rigid:
+      out[i] = inverseRigid(in[i]);
+      break;
+    case Mat4Class::Affine:
+      if (!tryInverseAffine(in[i], out[i])) {
+        out[i] = mat4();
+        ++singular;
+      }
+      break;
+    default:
+      if (kernels.inverse(in[i].v, out[i].v) == 0.0f) {
+        MATHS_COUNT(Diagnostic::SingularInverse);
+        out[i] = mat4();
+        ++singular;
+      }
+      break;
+    }
+  }
+  return singular;
+}
@@ -0,0 +1,124 @@
+#include "avx2.h"
+#include <immintrin.h>
+
+#define AVX_SHUFFLE(a, b, i0, i1, i2, i3)                                      \
+  _mm256_shuffle_ps(a, b, _MM_SHUFFLE(i3, i2, i1, i0))
+
+static inline __m256 load2x128(const float *lo, const float *hi) {
+  return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lo)),
+                              _mm_loadu_ps(hi), 1);
+}
+
+static inline void store2x128(float *lo, float *hi, __m256 a) {
+  _mm_storeu_ps(lo, _mm256_castps256_ps128(a));
+  _mm_storeu_ps(hi, _mm256_extractf128_ps(a, 1));
+}
+
+// Same in-lane shuffles as f4Load3/f4Store3, applied to points 0-3 in the low
+// half and points 4-7 in the high half.
+static inline void load3(const float *p, __m256 &x, __m256 &y, __m256 &z) {
+  __m256 a = load2x128(p, p + 12);
+  __m256 b = load2x128(p + 4, p + 16);
+  __m256 c = load2x128(p + 8, p + 20);
+  x = AVX_SHUFFLE(a, AVX_SHUFFLE(b, c, 2, 2, 1, 1), 0, 3, 0, 2);
+  y = AVX_SHUFFLE(AVX_SHUFFLE(a, b, 1, 1, 0, 0), AVX_SHUFFLE(b, c, 3, 3, 2, 2),
+                  0, 2, 0, 2);
+  z = AVX_SHUFFLE(AVX_SHUFFLE(a, b, 2, 2, 1, 1), AVX_SHUFFLE(c, c, 0, 0, 3, 3),
+                  0, 2, 0, 2);
+}
+
+static inline void store3(float *p, __m256 x, __m256 y, __m256 z) {
+  __m256 a = AVX_SHUFFLE(AVX_SHUFFLE(x, y, 0, 0, 0, 0),
+                         AVX_SHUFFLE(z, x, 0, 0, 1, 1), 0, 2, 0, 2);
+  __m256 b = AVX_SHUFFLE(AVX_SHUFFLE(y, z, 1, 1, 1, 1),
+                         AVX_SHUFFLE(x, y, 2, 2, 2, 2), 0, 2, 0, 2);
+  __m256 c = AVX_SHUFFLE(AVX_SHUFFLE(z, x, 2, 2, 3, 3),
+                         AVX_SHUFFLE(y, z, 3, 3, 3, 3), 0, 2, 0, 2);
+  store2x128(p, p + 12, a);
+  store2x128(p + 4, p + 16, b);
+  store2x128(p + 8, p + 20, c);
+}
+
+#undef AVX_SHUFFLE
+
+// Anonymous namespace: inline members must not be merged with code built
+// without AVX2 by the linker.
+namespace {
+struct Columns {
+  __m256 c[16];
+  inline Columns(const float *m) {
+    for (int i = 0; i < 16; ++i) {
+      c[i] = _mm256_set1_ps(m[i]);
+    }
+  }
+};
+} // namespace
+
+static inline __m256 row(const Columns &m, int r, __m256 x, __m256 y, __m256 z,
+                         __m256 w) {
+  return _mm256_fmadd_ps(
+      m.c[0 + r], x,
+      _mm256_fmadd_ps(m.c[4 + r], y,
+                      _mm256_fmadd_ps(m.c[8 + r], z,
+                                      _mm256_mul_ps(m.c[12 + r], w))));
+}
+
+static inline void transformOne(const float *m, float x, float y, float z,
+                                float *w, float translate, float *out) {
+  float _w = w ? *w : translate;
+  out[0] = m[0] * x + m[4] * y + m[8] * z + m[12] * _w;
+  out[1] = m[1] * x + m[5] * y + m[9] * z + m[13] * _w;
+  out[2] = m[2] * x + m[6] * y + m[10] * z + m[14] * _w;
+  if (w) {
+    *w = m[3] * x + m[7] * y + m[11] * z + m[15] * _w;
+  }
+}
+
+void transformAosAvx2(const float *m, const float *in, float *out, float *w,
+                      float translate, unsigned int count) {
+  Columns cols(m);
+  __m256 t = _mm256_set1_ps(translate);
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 x, y, z;
+    load3(in + i * 3, x, y, z);
+    __m256 _w = w ? _mm256_loadu_ps(w + i) : t;
+    store3(out + i * 3, row(cols, 0, x, y, z, _w), row(cols, 1, x, y, z, _w),
+           row(cols, 2, x, y, z, _w));
+    if (w) {
+      _mm256_storeu_ps(w + i, row(cols, 3, x, y, z, _w));
+    }
+  }
+  for (; i < count; ++i) {
+    const float *p = in + i * 3;
+    transformOne(m, p[0], p[1], p[2], w ? w + i : nullptr, translate,
+                 out + i * 3);
+  }
+}
+
+void transformSoaAvx2(const float *m, const float *x, const float *y,
+                      const float *z, float *outX, float *outY, float *outZ,
+                      float *w, float translate, unsigned int count) {
+  Columns cols(m);
+  __m256 t = _mm256_set1_ps(translate);
+  unsigned int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 _x = _mm256_loadu_ps(x + i);
+    __m256 _y = _mm256_loadu_ps(y + i);
+    __m256 _z = _mm256_loadu_ps(z + i);
+    __m256 _w = w ? _mm256_loadu_ps(w + i) : t;
+    _mm256_storeu_ps(outX + i, row(cols, 0, _x, _y, _z, _w));
+    _mm256_storeu_ps(outY + i, row(cols, 1, _x, _y, _z, _w));
+    _mm256_storeu_ps(outZ + i, row(cols, 2, _x, _y, _z, _w));
+    if (w) {
+      _mm256_storeu_ps(w + i, row(cols, 3, _x, _y, _z, _w));
+    }
+  }
+  for (; i < count; ++i) {
+    float r[3];
+    transformOne(m, x[i], y[i], z[i], w ? w + i : nullptr, translate, r);
+    outX[i] = r[0];
+    outY[i] = r[1];
+    outZ[i] = r[2];
+  }
+}
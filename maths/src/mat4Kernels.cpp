@@ -0,0 +1,128 @@
+#include "mat4Kernels.h"
+#include "avx2.h"
+#include "cpu.h"
+#include "mat4.h"
+#include "simd.h"
+
+#if defined(MATHS_SIMD_SCALAR)
+#define M4D(aRow, bCol)                                                        \
+  a[0 * 4 + aRow] * b[bCol * 4 + 0] + a[1 * 4 + aRow] * b[bCol * 4 + 1] +      \
+      a[2 * 4 + aRow] * b[bCol * 4 + 2] + a[3 * 4 + aRow] * b[bCol * 4 + 3]
+
+static void mulScalar(const float *a, const float *b, float *out) {
+  float r[16];
+  for (int col = 0; col < 4; ++col) {
+    for (int row = 0; row < 4; ++row) {
+      r[col * 4 + row] = M4D(row, col);
+    }
+  }
+  for (int i = 0; i < 16; ++i) {
+    out[i] = r[i];
+  }
+}
+
+#undef M4D
+
+static float inverseScalar(const float *m, float *out) {
+  mat4 in(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8], m[9], m[10],
+          m[11], m[12], m[13], m[14], m[15]);
+  float det = determinant(in);
+  if (det == 0.0f) {
+    return det;
+  }
+  mat4 r = adjugate(in) * (1.0f / det);
+  for (int i = 0; i < 16; ++i) {
+    out[i] = r.v[i];
+  }
+  return det;
+}
+
+#else
+static void mulSimd(const float *a, const float *b, float *out) {
+  f4 a0 = f4Load(a);
+  f4 a1 = f4Load(a + 4);
+  f4 a2 = f4Load(a + 8);
+  f4 a3 = f4Load(a + 12);
+  f4 r[4];
+  for (int col = 0; col < 4; ++col) {
+    const float *c = b + col * 4;
+    r[col] = f4MulAdd(a0, f4Splat(c[0]),
+                      f4MulAdd(a1, f4Splat(c[1]),
+                               f4MulAdd(a2, f4Splat(c[2]),
+                                        f4Mul(a3, f4Splat(c[3])))));
+  }
+  for (int col = 0; col < 4; ++col) {
+    f4Store(out + col * 4, r[col]);
+  }
+}
+
+// (s, -s, c, -c) -> (c, -c, s, -s), where s is the 2x2 determinant of rows 0-1
+// and c the one of rows 2-3, both taken from columns p and q.
+static inline f4 minors(f4 p, f4 q) {
+  f4 d = f4Mul(p, f4SwapPairs(q));
+  return f4SwapHalves(f4Sub(d, f4SwapPairs(d)));
+}
+
+// Laplace expansion over 2x2 sub-determinants: each of the twelve is computed
+// once (two per vector) and shared by the four adjugate rows.
+static float inverseSimd(const float *m, float *out) {
+  f4 c0 = f4Load(m);
+  f4 c1 = f4Load(m + 4);
+  f4 c2 = f4Load(m + 8);
+  f4 c3 = f4Load(m + 12);
+
+  f4 f01 = minors(c0, c1);
+  f4 f02 = minors(c0, c2);
+  f4 f03 = minors(c0, c3);
+  f4 f12 = minors(c1, c2);
+  f4 f13 = minors(c1, c3);
+  f4 f23 = minors(c2, c3);
+
+  f4 s0 = f4SwapPairs(c0);
+  f4 s1 = f4SwapPairs(c1);
+  f4 s2 = f4SwapPairs(c2);
+  f4 s3 = f4SwapPairs(c3);
+
+  // Rows of the adjugate
+  f4 r0 = f4MulAdd(s3, f12, f4Sub(f4Mul(s1, f23), f4Mul(s2, f13)));
+  f4 r1 = f4Sub(f4Sub(f4Mul(s2, f03), f4Mul(s0, f23)), f4Mul(s3, f02));
+  f4 r2 = f4MulAdd(s3, f01, f4Sub(f4Mul(s0, f13), f4Mul(s1, f03)));
+  f4 r3 = f4Sub(f4Sub(f4Mul(s1, f02), f4Mul(s0, f12)), f4Mul(s2, f01));
+
+  f4 d = f4Mul(r0, c0);
+  d = f4Add(d, f4SwapPairs(d));
+  float det = f4First(f4Add(d, f4SwapHalves(d)));
+  if (det == 0.0f) {
+    return det;
+  }
+
+  f4 invDet = f4Splat(1.0f / det);
+  f4Transpose(r0, r1, r2, r3);
+  f4Store(out, f4Mul(r0, invDet));
+  f4Store(out + 4, f4Mul(r1, invDet));
+  f4Store(out + 8, f4Mul(r2, invDet));
+  f4Store(out + 12, f4Mul(r3, invDet));
+  return det;
+}
+#endif
+
+static Mat4Kernels selectMat4Kernels() {
+#if defined(MATHS_SIMD_SCALAR)
+  return {mulScalar, inverseScalar};
+#else
+#ifdef MATHS_AVX2
+  if (cpuHasAvx2()) {
+    return {mat4MulAvx2, inverseSimd};
+  }
+#endif
+  return {mulSimd, inverseSimd};
+#endif
+}
+
+const Mat4Kernels &mat4Kernels() {
+  static const Mat4Kernels kernels = selectMat4Kernels();
+  return kernels;
+}
+
+// Resolve the table while the library is loaded rather than on first use.
+[[maybe_unused]] static const Mat4Kernels &loadTimeKernels = mat4Kernels();
@@ -0,0 +1,12 @@
+#pragma once
+// Backend for the mat4 operations that have SIMD implementations. The table
+// is selected once from the CPU features; the scalar code is the fallback
+// when neither SSE nor NEON is available.
+
+struct Mat4Kernels {
+  void (*mul)(const float *a, const float *b, float *out);
+  // Returns the determinant; out is only written when it is not zero.
+  float (*inverse)(const float *m, float *out);
+};
+
+const Mat4Kernels &mat4Kernels();
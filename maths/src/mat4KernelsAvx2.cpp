@@ -0,0 +1,24 @@
+#include "avx2.h"
+#include <immintrin.h>
+
+void mat4MulAvx2(const float *a, const float *b, float *out) {
+  __m256 a0 = _mm256_broadcast_ps((const __m128 *)a);
+  __m256 a1 = _mm256_broadcast_ps((const __m128 *)(a + 4));
+  __m256 a2 = _mm256_broadcast_ps((const __m128 *)(a + 8));
+  __m256 a3 = _mm256_broadcast_ps((const __m128 *)(a + 12));
+  __m256 b01 = _mm256_loadu_ps(b);
+  __m256 b23 = _mm256_loadu_ps(b + 8);
+
+  __m256 r01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+  r01 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b01, 0x55), r01);
+  r01 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b01, 0xAA), r01);
+  r01 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b01, 0xFF), r01);
+
+  __m256 r23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+  r23 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b23, 0x55), r23);
+  r23 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b23, 0xAA), r23);
+  r23 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b23, 0xFF), r23);
+
+  _mm256_storeu_ps(out, r01);
+  _mm256_storeu_ps(out + 8, r23);
+}
@@ -0,0 +1,246 @@
+#include "parallel.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// The unclaimed part of one thread's share, begin in the high half and end
+// in the low half, so the owner taking from the front and thieves cutting
+// from the back both update it with one compare-exchange.
+struct alignas(64) RangeSlot {
+  std::atomic<unsigned long long> range;
+};
+
+inline unsigned long long packRange(unsigned int begin, unsigned int end) {
+  return (unsigned long long)begin << 32 | end;
+}
+
+struct Job {
+  ParallelTask task;
+  void *context;
+  unsigned int grain;
+  unsigned int slotCount;
+  RangeSlot *slots;
+};
+
+thread_local bool insideTask = false;
+
+// Takes up to grain items from the front of slot
+bool claim(RangeSlot &slot, unsigned int grain, unsigned int &begin,
+           unsigned int &end) {
+  unsigned long long range = slot.range.load(std::memory_order_relaxed);
+  for (;;) {
+    unsigned int b = (unsigned int)(range >> 32);
+    unsigned int e = (unsigned int)range;
+    if (b >= e) {
+      return false;
+    }
+    unsigned int taken = e - b < grain ? e : b + grain;
+    if (slot.range.compare_exchange_weak(range, packRange(taken, e),
+                                         std::memory_order_relaxed)) {
+      begin = b;
+      end = taken;
+      return true;
+    }
+  }
+}
+
+// Moves the back half of another slot's range into self's empty slot
+bool steal(const Job &job, unsigned int self) {
+  for (unsigned int i = 1; i < job.slotCount; ++i) {
+    RangeSlot &victim = job.slots[(self + i) % job.slotCount];
+    unsigned long long range = victim.range.load(std::memory_order_relaxed);
+    for (;;) {
+      unsigned int b = (unsigned int)(range >> 32);
+      unsigned int e = (unsigned int)range;
+      if (b >= e) {
+        break;
+      }
+      unsigned int middle = b + (e - b) / 2;
+      if (e - b <= job.grain) {
+        middle = b; // Too small to split, take all of it
+      }
+      if (victim.range.compare_exchange_weak(range, packRange(b, middle),
+                                             std::memory_order_relaxed)) {
+        job.slots[self].range.store(packRange(middle, e),
+                                    std::memory_order_relaxed);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void runJob(const Job &job, unsigned int self) {
+  bool wasInside = insideTask;
+  insideTask = true;
+  unsigned int begin, end;
+  do {
+    while (claim(job.slots[self], job.grain, begin, end)) {
+      job.task(job.context, begin, end);
+    }
+  } while (steal(job, self));
+  insideTask = wasInside;
+}
+
+void runSerial(unsigned int count, unsigned int grain, ParallelTask task,
+               void *context) {
+  for (unsigned int begin = 0; begin < count; begin += grain) {
+    task(context, begin, count - begin < grain ? count : begin + grain);
+  }
+}
+
+class ThreadPool {
+public:
+  explicit ThreadPool(unsigned int threadCount)
+      : slots(new RangeSlot[threadCount]), threadCount(threadCount) {
+    for (unsigned int i = 1; i < threadCount; ++i) {
+      workers.emplace_back([this, i] { work(i); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &t : workers) {
+      t.join();
+    }
+  }
+
+  unsigned int size() const { return threadCount; }
+
+  // False when another thread is already using the pool
+  bool run(unsigned int count, unsigned int grain, ParallelTask task,
+           void *context) {
+    std::unique_lock<std::mutex> busy(callMutex, std::try_to_lock);
+    if (!busy.owns_lock()) {
+      return false;
+    }
+    unsigned int chunks = (count + grain - 1) / grain;
+    Job job = {task, context, grain,
+               chunks < threadCount ? chunks : threadCount, slots.get()};
+    for (unsigned int i = 0; i < threadCount; ++i) {
+      unsigned int begin = i < job.slotCount ? share(count, i, job) : count;
+      unsigned int end = i < job.slotCount ? share(count, i + 1, job) : count;
+      slots[i].range.store(packRange(begin, end), std::memory_order_relaxed);
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      current = &job;
+      ++generation;
+    }
+    wake.notify_all();
+
+    runJob(job, 0);
+
+    // Every item is claimed now; wait for the workers still running theirs.
+    // A worker that wakes after this sees no job.
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return joined == 0; });
+    current = nullptr;
+    return true;
+  }
+
+private:
+  static unsigned int share(unsigned int count, unsigned int i,
+                            const Job &job) {
+    return (unsigned int)((unsigned long long)count * i / job.slotCount);
+  }
+
+  void work(unsigned int self) {
+    unsigned long long seen = 0;
+    for (;;) {
+      const Job *job;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) {
+          return;
+        }
+        seen = generation;
+        job = current;
+        if (!job || self >= job->slotCount) {
+          continue;
+        }
+        ++joined;
+      }
+      runJob(*job, self);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--joined == 0) {
+          finished.notify_one();
+        }
+      }
+    }
+  }
+
+  std::unique_ptr<RangeSlot[]> slots;
+  unsigned int threadCount;
+  std::vector<std::thread> workers;
+  std::mutex callMutex;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable finished;
+  const Job *current = nullptr;
+  unsigned long long generation = 0;
+  unsigned int joined = 0;
+  bool stopping = false;
+};
+
+unsigned int hardwareThreads() {
+  unsigned int count = std::thread::hardware_concurrency();
+  return count == 0 ? 1 : count;
+}
+
+std::mutex poolMutex;
+std::unique_ptr<ThreadPool> pool;
+std::atomic<unsigned int> requestedThreads(0);
+ParallelScheduler scheduler = {nullptr, nullptr};
+
+ThreadPool &getPool() {
+  std::lock_guard<std::mutex> lock(poolMutex);
+  if (!pool) {
+    unsigned int count = requestedThreads.load();
+    pool.reset(new ThreadPool(count == 0 ? hardwareThreads() : count));
+  }
+  return *pool;
+}
+
+} // namespace
+
+unsigned int parallelThreadCount() {
+  unsigned int count = requestedThreads.load();
+  return count == 0 ? hardwareThreads() : count;
+}
+
+void setParallelThreadCount(unsigned int count) {
+  std::lock_guard<std::mutex> lock(poolMutex);
+  requestedThreads = count;
+  pool.reset();
+}
+
+void setParallelScheduler(const ParallelScheduler *s) {
+  scheduler = s ? *s : ParallelScheduler{nullptr, nullptr};
+}
+
+void parallelFor(unsigned int count, unsigned int grain, ParallelTask task,
+                 void *context) {
+  if (grain == 0) {
+    grain = 1;
+  }
+  if (scheduler.run) {
+    scheduler.run(scheduler.user, count, grain, task, context);
+    return;
+  }
+  if (count <= grain || insideTask || parallelThreadCount() == 1 ||
+      !getPool().run(count, grain, task, context)) {
+    runSerial(count, grain, task, context);
+  }
+}
@@ -0,0 +1,480 @@
+#include "quantize.h"
+#include "transformSimd.h"
+#include <math.h>
+#include <string.h>
+
+static const float kInvSqrt2 = 0.70710678f;
+static const float kSqrt2 = 1.41421356f;
+// Smallest-three codes are centered so that zero is exact: code - half maps
+// [-1/sqrt(2), 1/sqrt(2)] onto [-half, half].
+static const float kHalfCode48 = 16383.0f; // 15 bits per component
+static const float kHalfCode32 = 511.0f;   // 10 bits per component
+static const float kMaxCode16 = 65535.0f;
+
+// Components kept for each dropped one, in the order they are stored
+static const int kKept[4][3] = {{1, 2, 3}, {0, 2, 3}, {0, 1, 3}, {0, 1, 2}};
+
+struct SmallestThree {
+  int index;
+  int codes[3];
+};
+
+static inline int clampCode(float c, float maxCode) {
+  return (int)lrintf(c < 0.0f ? 0.0f : (c > maxCode ? maxCode : c));
+}
+
+// Picks the component to drop and returns the factor that normalizes q and
+// makes the dropped component positive.
+static inline float prepareSmallestThree(const float *v, float lenSq,
+                                         int &index) {
+  index = 0;
+  float largest = fabsf(v[0]);
+  for (int i = 1; i < 4; ++i) {
+    if (fabsf(v[i]) > largest) {
+      largest = fabsf(v[i]);
+      index = i;
+    }
+  }
+  float invLen = 1.0f / sqrtf(lenSq);
+  return v[index] < 0.0f ? -invLen : invLen;
+}
+
+// Same summation order as dot(const quatX4 &, const quatX4 &), so single and
+// batch encodes agree.
+static inline float lenSqX4Order(const quat &q) {
+  return q.x * q.x + (q.y * q.y + (q.z * q.z + q.w * q.w));
+}
+
+static SmallestThree encodeSmallestThree(const quat &q, float halfCode) {
+  float lenSq = lenSqX4Order(q);
+  const float identity[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+  const float *v = lenSq < QUAT_EPSILON ? identity : q.v;
+  SmallestThree s;
+  float factor =
+      prepareSmallestThree(v, lenSq < QUAT_EPSILON ? 1.0f : lenSq, s.index);
+  float scale = kSqrt2 * halfCode;
+  for (int k = 0; k < 3; ++k) {
+    float n = v[kKept[s.index][k]] * factor;
+    s.codes[k] = clampCode(n * scale + halfCode, 2.0f * halfCode);
+  }
+  return s;
+}
+
+static quat decodeSmallestThree(const SmallestThree &s, float halfCode) {
+  float step = kInvSqrt2 / halfCode;
+  float v[4];
+  float sum = 0.0f;
+  for (int k = 0; k < 3; ++k) {
+    float c = (float)(s.codes[k] - (int)halfCode) * step;
+    v[kKept[s.index][k]] = c;
+    sum = c * c + sum;
+  }
+  float rest = 1.0f - sum;
+  v[s.index] = sqrtf(rest > 0.0f ? rest : 0.0f);
+  return quat(v[0], v[1], v[2], v[3]);
+}
+
+// Lane versions of the two above. Picking the dropped component is per lane;
+// the scaling, rounding, sqrt and placing the rebuilt component are SIMD.
+static inline void encodeSmallestThreeX4(const quatX4 &q, float halfCode,
+                                         SmallestThree s[4]) {
+  float lanes[4][4], lenSq[4];
+  f4Store(lanes[0], q.x);
+  f4Store(lanes[1], q.y);
+  f4Store(lanes[2], q.z);
+  f4Store(lanes[3], q.w);
+  f4Store(lenSq, dot(q, q));
+
+  float kept[3][4];
+  for (int l = 0; l < 4; ++l) {
+    float v[4] = {lanes[0][l], lanes[1][l], lanes[2][l], lanes[3][l]};
+    if (lenSq[l] < QUAT_EPSILON) {
+      v[0] = v[1] = v[2] = 0.0f;
+      v[3] = lenSq[l] = 1.0f;
+    }
+    float factor = prepareSmallestThree(v, lenSq[l], s[l].index);
+    for (int k = 0; k < 3; ++k) {
+      kept[k][l] = v[kKept[s[l].index][k]] * factor;
+    }
+  }
+
+  f4 scale = f4Splat(kSqrt2 * halfCode), bias = f4Splat(halfCode);
+  f4 zero = f4Splat(0.0f), top = f4Splat(2.0f * halfCode);
+  for (int k = 0; k < 3; ++k) {
+    int codes[4];
+    f4 c = f4MulAdd(f4Load(kept[k]), scale, bias);
+    f4StoreInt(codes, f4Min(f4Max(c, zero), top));
+    for (int l = 0; l < 4; ++l) {
+      s[l].codes[k] = codes[l];
+    }
+  }
+}
+
+static inline quatX4 decodeSmallestThreeX4(const SmallestThree s[4],
+                                           float halfCode) {
+  f4 step = f4Splat(kInvSqrt2 / halfCode);
+  f4 sum = f4Splat(0.0f);
+  f4 c[3];
+  for (int k = 0; k < 3; ++k) {
+    int h = (int)halfCode;
+    c[k] = f4Mul(f4Set((float)(s[0].codes[k] - h), (float)(s[1].codes[k] - h),
+                       (float)(s[2].codes[k] - h), (float)(s[3].codes[k] - h)),
+                 step);
+    sum = f4MulAdd(c[k], c[k], sum);
+  }
+  f4 rest = f4Max(f4Sub(f4Splat(1.0f), sum), f4Splat(0.0f));
+  f4 d = f4Sqrt(rest);
+
+  // Shift the stored components past the dropped one, following kKept
+  f4 index = f4Set((float)s[0].index, (float)s[1].index, (float)s[2].index,
+                   (float)s[3].index);
+  f4 is0 = f4Less(index, f4Splat(0.5f));
+  f4 upTo1 = f4Less(index, f4Splat(1.5f));
+  f4 upTo2 = f4Less(index, f4Splat(2.5f));
+  return {f4Select(is0, d, c[0]),
+          f4Select(is0, c[0], f4Select(upTo1, d, c[1])),
+          f4Select(upTo1, c[1], f4Select(upTo2, d, c[2])),
+          f4Select(upTo2, c[2], d)};
+}
+
+// 48 bits: the index is split over the top bits of the first two words
+static inline PackedQuat48 toBits48(const SmallestThree &s) {
+  PackedQuat48 p;
+  p.bits[0] = (unsigned short)(s.codes[0] | (s.index >> 1) << 15);
+  p.bits[1] = (unsigned short)(s.codes[1] | (s.index & 1) << 15);
+  p.bits[2] = (unsigned short)s.codes[2];
+  return p;
+}
+
+static inline SmallestThree fromBits48(const PackedQuat48 &p) {
+  SmallestThree s;
+  s.index = (p.bits[0] >> 15) << 1 | p.bits[1] >> 15;
+  s.codes[0] = p.bits[0] & 0x7fff;
+  s.codes[1] = p.bits[1] & 0x7fff;
+  s.codes[2] = p.bits[2] & 0x7fff;
+  return s;
+}
+
+// 32 bits: index in the top two bits, then the codes from high to low
+static inline PackedQuat32 toBits32(const SmallestThree &s) {
+  unsigned int bits = (unsigned int)s.index << 30 |
+                      (unsigned int)s.codes[0] << 20 |
+                      (unsigned int)s.codes[1] << 10 | (unsigned int)s.codes[2];
+  PackedQuat32 p;
+  p.bits[0] = (unsigned short)(bits & 0xffff);
+  p.bits[1] = (unsigned short)(bits >> 16);
+  return p;
+}
+
+static inline SmallestThree fromBits32(const PackedQuat32 &p) {
+  unsigned int bits = (unsigned int)p.bits[1] << 16 | p.bits[0];
+  SmallestThree s;
+  s.index = (int)(bits >> 30);
+  s.codes[0] = (int)(bits >> 20) & 0x3ff;
+  s.codes[1] = (int)(bits >> 10) & 0x3ff;
+  s.codes[2] = (int)bits & 0x3ff;
+  return s;
+}
+
+PackedQuat48 packQuat48(const quat &q) {
+  return toBits48(encodeSmallestThree(q, kHalfCode48));
+}
+
+quat unpackQuat48(const PackedQuat48 &p) {
+  return decodeSmallestThree(fromBits48(p), kHalfCode48);
+}
+
+PackedQuat32 packQuat32(const quat &q) {
+  return toBits32(encodeSmallestThree(q, kHalfCode32));
+}
+
+quat unpackQuat32(const PackedQuat32 &p) {
+  return decodeSmallestThree(fromBits32(p), kHalfCode32);
+}
+
+unsigned short floatToHalf(float f) {
+  unsigned int bits;
+  memcpy(&bits, &f, sizeof(bits));
+  unsigned short sign = (unsigned short)((bits >> 16) & 0x8000);
+  unsigned int magnitude = bits & 0x7fffffff;
+  if (magnitude >= 0x7f800000) {
+    // Infinity stays infinity, NaN stays a quiet NaN
+    return sign | (magnitude > 0x7f800000 ? 0x7e00 : 0x7c00);
+  }
+  if (magnitude >= 0x477ff000) {
+    // 65520 and up round past the largest half
+    return sign | 0x7c00;
+  }
+  if (magnitude < 0x38800000) {
+    // Below 2^-14 the half is subnormal: a multiple of 2^-24
+    return sign | (unsigned short)lrintf(fabsf(f) * 16777216.0f);
+  }
+  // Rebias the exponent and round the mantissa to nearest even
+  unsigned int rebiased = magnitude - 0x38000000;
+  rebiased += 0xfff + ((rebiased >> 13) & 1);
+  return sign | (unsigned short)(rebiased >> 13);
+}
+
+float halfToFloat(unsigned short h) {
+  unsigned int sign = (unsigned int)(h & 0x8000) << 16;
+  unsigned int exponent = (h >> 10) & 0x1f;
+  unsigned int mantissa = h & 0x3ff;
+  unsigned int bits;
+  if (exponent == 0) {
+    float f = (float)mantissa * 5.9604645e-8f; // 2^-24
+    return sign ? -f : f;
+  } else if (exponent == 31) {
+    bits = sign | 0x7f800000 | mantissa << 13;
+  } else {
+    bits = sign | (exponent + 112) << 23 | mantissa << 13;
+  }
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+PositionRange positionRange(const Transform *t, unsigned int count) {
+  if (count == 0) {
+    return {vec3(0, 0, 0), vec3(0, 0, 0)};
+  }
+  vec3 min = t[0].position, max = t[0].position;
+  for (unsigned int i = 1; i < count; ++i) {
+    const vec3 &p = t[i].position;
+    min = vec3(fminf(min.x, p.x), fminf(min.y, p.y), fminf(min.z, p.z));
+    max = vec3(fmaxf(max.x, p.x), fmaxf(max.y, p.y), fmaxf(max.z, p.z));
+  }
+  return {min, max};
+}
+
+// Per axis factors from position to code and back. An empty axis packs to
+// zero and unpacks to min.
+struct RangeScale {
+  vec3 min;
+  vec3 toCode;
+  vec3 toPosition;
+};
+
+static inline float axisToCode(float extent) {
+  return extent > 0.0f ? kMaxCode16 / extent : 0.0f;
+}
+
+static RangeScale rangeScale(const PositionRange &range) {
+  vec3 extent = range.max - range.min;
+  return {range.min,
+          vec3(axisToCode(extent.x), axisToCode(extent.y),
+               axisToCode(extent.z)),
+          extent * (1.0f / kMaxCode16)};
+}
+
+PackedVec3 packPosition(const vec3 &p, const PositionRange &range) {
+  RangeScale r = rangeScale(range);
+  vec3 c = (p - r.min) * r.toCode;
+  return {(unsigned short)clampCode(c.x, kMaxCode16),
+          (unsigned short)clampCode(c.y, kMaxCode16),
+          (unsigned short)clampCode(c.z, kMaxCode16)};
+}
+
+static inline vec3 unpackPosition(const PackedVec3 &p, const RangeScale &r) {
+  return vec3((float)p.x * r.toPosition.x + r.min.x,
+              (float)p.y * r.toPosition.y + r.min.y,
+              (float)p.z * r.toPosition.z + r.min.z);
+}
+
+vec3 unpackPosition(const PackedVec3 &p, const PositionRange &range) {
+  return unpackPosition(p, rangeScale(range));
+}
+
+PackedVec3 packHalf(const vec3 &v) {
+  return {floatToHalf(v.x), floatToHalf(v.y), floatToHalf(v.z)};
+}
+
+vec3 unpackHalf(const PackedVec3 &p) {
+  return vec3(halfToFloat(p.x), halfToFloat(p.y), halfToFloat(p.z));
+}
+
+PackedTransform packTransform(const Transform &t, const PositionRange &range) {
+  return {packPosition(t.position, range), packQuat48(t.rotation),
+          floatToHalf(t.scale.x)};
+}
+
+Transform unpackTransform(const PackedTransform &p,
+                          const PositionRange &range) {
+  float scale = halfToFloat(p.scale);
+  return Transform(unpackPosition(p.position, range),
+                   unpackQuat48(p.rotation), vec3(scale, scale, scale));
+}
+
+PackedRigidTransform packRigidTransform(const Transform &t,
+                                        const PositionRange &range) {
+  return {packPosition(t.position, range), packQuat32(t.rotation)};
+}
+
+Transform unpackRigidTransform(const PackedRigidTransform &p,
+                               const PositionRange &range) {
+  return Transform(unpackPosition(p.position, range),
+                   unpackQuat32(p.rotation), vec3(1, 1, 1));
+}
+
+void packQuat48(const quat *in, PackedQuat48 *out, unsigned int count) {
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    SmallestThree s[4];
+    encodeSmallestThreeX4(loadQuatX4(in + i), kHalfCode48, s);
+    for (int l = 0; l < 4; ++l) {
+      out[i + l] = toBits48(s[l]);
+    }
+  }
+  for (; i < count; ++i) {
+    out[i] = packQuat48(in[i]);
+  }
+}
+
+void unpackQuat48(const PackedQuat48 *in, quat *out, unsigned int count) {
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    SmallestThree s[4] = {fromBits48(in[i]), fromBits48(in[i + 1]),
+                          fromBits48(in[i + 2]), fromBits48(in[i + 3])};
+    storeQuatX4(decodeSmallestThreeX4(s, kHalfCode48), out + i);
+  }
+  for (; i < count; ++i) {
+    out[i] = unpackQuat48(in[i]);
+  }
+}
+
+void packQuat32(const quat *in, PackedQuat32 *out, unsigned int count) {
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    SmallestThree s[4];
+    encodeSmallestThreeX4(loadQuatX4(in + i), kHalfCode32, s);
+    for (int l = 0; l < 4; ++l) {
+      out[i + l] = toBits32(s[l]);
+    }
+  }
+  for (; i < count; ++i) {
+    out[i] = packQuat32(in[i]);
+  }
+}
+
+void unpackQuat32(const PackedQuat32 *in, quat *out, unsigned int count) {
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    SmallestThree s[4] = {fromBits32(in[i]), fromBits32(in[i + 1]),
+                          fromBits32(in[i + 2]), fromBits32(in[i + 3])};
+    storeQuatX4(decodeSmallestThreeX4(s, kHalfCode32), out + i);
+  }
+  for (; i < count; ++i) {
+    out[i] = unpackQuat32(in[i]);
+  }
+}
+
+// Lane versions of packPosition and unpackPosition
+static inline void packPositionX4(const vec3X4 &p, const RangeScale &r,
+                                  PackedVec3 *out) {
+  const f4 in[3] = {p.x, p.y, p.z};
+  const float min[3] = {r.min.x, r.min.y, r.min.z};
+  const float toCode[3] = {r.toCode.x, r.toCode.y, r.toCode.z};
+  f4 zero = f4Splat(0.0f), top = f4Splat(kMaxCode16);
+  int codes[3][4];
+  for (int a = 0; a < 3; ++a) {
+    f4 c = f4Mul(f4Sub(in[a], f4Splat(min[a])), f4Splat(toCode[a]));
+    f4StoreInt(codes[a], f4Min(f4Max(c, zero), top));
+  }
+  for (int l = 0; l < 4; ++l) {
+    out[l] = {(unsigned short)codes[0][l], (unsigned short)codes[1][l],
+              (unsigned short)codes[2][l]};
+  }
+}
+
+static inline vec3X4 unpackPositionX4(const PackedVec3 *const p[4],
+                                      const RangeScale &r) {
+  f4 x = f4Set(p[0]->x, p[1]->x, p[2]->x, p[3]->x);
+  f4 y = f4Set(p[0]->y, p[1]->y, p[2]->y, p[3]->y);
+  f4 z = f4Set(p[0]->z, p[1]->z, p[2]->z, p[3]->z);
+  return {f4MulAdd(x, f4Splat(r.toPosition.x), f4Splat(r.min.x)),
+          f4MulAdd(y, f4Splat(r.toPosition.y), f4Splat(r.min.y)),
+          f4MulAdd(z, f4Splat(r.toPosition.z), f4Splat(r.min.z))};
+}
+
+void packTransform(const Transform *in, const PositionRange &range,
+                   PackedTransform *out, unsigned int count) {
+  RangeScale r = rangeScale(range);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    TransformX4 t = loadTransformX4(in + i, in + i + 1, in + i + 2, in + i + 3);
+    PackedVec3 positions[4];
+    SmallestThree s[4];
+    packPositionX4(t.position, r, positions);
+    encodeSmallestThreeX4(t.rotation, kHalfCode48, s);
+    for (int l = 0; l < 4; ++l) {
+      out[i + l] = {positions[l], toBits48(s[l]),
+                    floatToHalf(in[i + l].scale.x)};
+    }
+  }
+  for (; i < count; ++i) {
+    out[i] = packTransform(in[i], range);
+  }
+}
+
+void unpackTransform(const PackedTransform *in, const PositionRange &range,
+                     Transform *out, unsigned int count) {
+  RangeScale r = rangeScale(range);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const PackedTransform *p = in + i;
+    const PackedVec3 *const positions[4] = {&p[0].position, &p[1].position,
+                                            &p[2].position, &p[3].position};
+    SmallestThree s[4] = {fromBits48(p[0].rotation), fromBits48(p[1].rotation),
+                          fromBits48(p[2].rotation), fromBits48(p[3].rotation)};
+    TransformX4 t;
+    t.position = unpackPositionX4(positions, r);
+    t.rotation = decodeSmallestThreeX4(s, kHalfCode48);
+    t.scale.x = t.scale.y = t.scale.z =
+        f4Set(halfToFloat(p[0].scale), halfToFloat(p[1].scale),
+              halfToFloat(p[2].scale), halfToFloat(p[3].scale));
+    storeTransformX4(t, out + i, out + i + 1, out + i + 2, out + i + 3);
+  }
+  for (; i < count; ++i) {
+    out[i] = unpackTransform(in[i], range);
+  }
+}
+
+void packRigidTransform(const Transform *in, const PositionRange &range,
+                        PackedRigidTransform *out, unsigned int count) {
+  RangeScale r = rangeScale(range);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    TransformX4 t = loadTransformX4(in + i, in + i + 1, in + i + 2, in + i + 3);
+    PackedVec3 positions[4];
+    SmallestThree s[4];
+    packPositionX4(t.position, r, positions);
+    encodeSmallestThreeX4(t.rotation, kHalfCode32, s);
+    for (int l = 0; l < 4; ++l) {
+      out[i + l] = {positions[l], toBits32(s[l])};
+    }
+  }
+  for (; i < count; ++i) {
+    out[i] = packRigidTransform(in[i], range);
+  }
+}
+
+void unpackRigidTransform(const PackedRigidTransform *in,
+                          const PositionRange &range, Transform *out,
+                          unsigned int count) {
+  RangeScale r = rangeScale(range);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const PackedRigidTransform *p = in + i;
+    const PackedVec3 *const positions[4] = {&p[0].position, &p[1].position,
+                                            &p[2].position, &p[3].position};
+    SmallestThree s[4] = {fromBits32(p[0].rotation), fromBits32(p[1].rotation),
+                          fromBits32(p[2].rotation), fromBits32(p[3].rotation)};
+    TransformX4 t;
+    t.position = unpackPositionX4(positions, r);
+    t.rotation = decodeSmallestThreeX4(s, kHalfCode32);
+    t.scale.x = t.scale.y = t.scale.z = f4Splat(1.0f);
+    storeTransformX4(t, out + i, out + i + 1, out + i + 2, out + i + 3);
+  }
+  for (; i < count; ++i) {
+    out[i] = unpackRigidTransform(in[i], range);
+  }
+}
@@ -0,0 +1,104 @@
+#include "parallel.h"
+#include "quat.h"
+#include "transformSimd.h"
+
+// Same coefficients as fastSlerp(const quat &, const quat &, float)
+static const float slerpU[12] = {
+    1.0f / (1 * 3),   1.0f / (2 * 5),   1.0f / (3 * 7),
+    1.0f / (4 * 9),   1.0f / (5 * 11),  1.0f / (6 * 13),
+    1.0f / (7 * 15),  1.0f / (8 * 17),  1.0f / (9 * 19),
+    1.0f / (10 * 21), 1.0f / (11 * 23), 1.89372f / (12 * 25)};
+static const float slerpV[12] = {1.0f / 3,   2.0f / 5,   3.0f / 7,
+                                 4.0f / 9,   5.0f / 11,  6.0f / 13,
+                                 7.0f / 15,  8.0f / 17,  9.0f / 19,
+                                 10.0f / 21, 11.0f / 23, 1.89372f * 12 / 25};
+
+// Lane version of fastSlerp(const quat &, const quat &, float)
+static inline quatX4 fastSlerpX4(const quatX4 &from, const quatX4 &to, f4 t) {
+  f4 one = f4Splat(1.0f);
+  f4 x = dot(from, to);
+  f4 xm1 = f4Sub(f4MulSign(x, x), one);
+  f4 d = f4Sub(one, t);
+  f4 tt = f4Mul(t, t);
+  f4 dd = f4Mul(d, d);
+  f4 ct = one;
+  f4 cd = one;
+  for (int i = 11; i >= 0; --i) {
+    f4 u = f4Splat(slerpU[i]);
+    f4 v = f4Splat(slerpV[i]);
+    ct = f4MulAdd(f4Mul(f4Sub(f4Mul(u, tt), v), xm1), ct, one);
+    cd = f4MulAdd(f4Mul(f4Sub(f4Mul(u, dd), v), xm1), cd, one);
+  }
+  ct = f4MulSign(f4Mul(ct, t), x);
+  cd = f4Mul(cd, d);
+  return from * cd + to * ct;
+}
+
+void fastSlerp(const quat *from, const quat *to, float t, quat *out,
+               unsigned int count) {
+  f4 t4 = f4Splat(t);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    storeQuatX4(fastSlerpX4(loadQuatX4(from + i), loadQuatX4(to + i), t4),
+                out + i);
+  }
+  for (; i < count; ++i) {
+    out[i] = fastSlerp(from[i], to[i], t);
+  }
+}
+
+void fastSlerp(const quat *from, const quat *to, const float *t, quat *out,
+               unsigned int count) {
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    storeQuatX4(
+        fastSlerpX4(loadQuatX4(from + i), loadQuatX4(to + i), f4Load(t + i)),
+        out + i);
+  }
+  for (; i < count; ++i) {
+    out[i] = fastSlerp(from[i], to[i], t[i]);
+  }
+}
+
+void quatToMat4(const quat *in, mat4 *out, unsigned int count) {
+  TransformX4 t;
+  t.position = {f4Splat(0.0f), f4Splat(0.0f), f4Splat(0.0f)};
+  t.scale = {f4Splat(1.0f), f4Splat(1.0f), f4Splat(1.0f)};
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    t.rotation = loadQuatX4(in + i);
+    storeMat4X4(t, out + i, out + i + 1, out + i + 2, out + i + 3);
+  }
+  for (; i < count; ++i) {
+    out[i] = quatToMat4(in[i]);
+  }
+}
+
+void mat4ToQuat(const mat4 *in, quat *out, unsigned int count) {
+  for (unsigned int i = 0; i < count; ++i) {
+    out[i] = mat4ToQuat(in[i]);
+  }
+}
+
+void normalize(quat *q, unsigned int count) {
+  f4 one = f4Splat(1.0f), epsilon = f4Splat(QUAT_EPSILON);
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    quatX4 v = loadQuatX4(q + i);
+    f4 lenSq = dot(v, v);
+    f4 invLen = f4Div(one, f4Sqrt(lenSq));
+    // Lanes below epsilon keep a factor of one
+    invLen = f4Select(f4Less(lenSq, epsilon), one, invLen);
+    storeQuatX4(v * invLen, q + i);
+  }
+  for (; i < count; ++i) {
+    normalize(q[i]);
+  }
+}
+
+void normalizeParallel(quat *q, unsigned int count, unsigned int grain) {
+  parallelFor(count, grain ? grain : 8192,
+              [&](unsigned int begin, unsigned int end) {
+                normalize(q + begin, end - begin);
+              });
+}
@@ -0,0 +1,335 @@
+#include "ray.h"
+#include "raySimd.h"
+#include <math.h>
+
+// Same summation order as dot(const vec3X4 &, const vec3X4 &), so the single
+// tests agree with the lanes.
+static inline float dotLanes(const vec3 &a, const vec3 &b) {
+  return a.x * b.x + (a.y * b.y + a.z * b.z);
+}
+
+// Written with the operand order of the SSE min and max, which return the
+// second operand when either is NaN, so rays parallel to a slab and lying in
+// its plane come out the same in every path.
+static inline float minLanes(float a, float b) { return a < b ? a : b; }
+static inline float maxLanes(float a, float b) { return a > b ? a : b; }
+
+bool intersectAabb(const Ray &ray, const Aabb &box, float maxT, float &t) {
+  float lo[3], hi[3];
+  for (int k = 0; k < 3; ++k) {
+    float inv = 1.0f / ray.direction.v[k];
+    float t0 = (box.min.v[k] - ray.origin.v[k]) * inv;
+    float t1 = (box.max.v[k] - ray.origin.v[k]) * inv;
+    lo[k] = minLanes(t0, t1);
+    hi[k] = maxLanes(t0, t1);
+  }
+  float tnear = maxLanes(maxLanes(lo[0], lo[1]), lo[2]);
+  float tfar = minLanes(minLanes(hi[0], hi[1]), hi[2]);
+  float hit = maxLanes(tnear, 0.0f);
+  if (hit < maxT && !(tfar < hit)) {
+    t = hit;
+    return true;
+  }
+  return false;
+}
+
+bool intersectSphere(const Ray &ray, const Sphere &sphere, float maxT,
+                     float &t) {
+  vec3 oc = ray.origin - sphere.center;
+  float a = dotLanes(ray.direction, ray.direction);
+  float b = dotLanes(oc, ray.direction);
+  float c = dotLanes(oc, oc) - sphere.radius * sphere.radius;
+  float disc = b * b - a * c;
+  if (disc < 0.0f) {
+    return false;
+  }
+  float s = sqrtf(disc);
+  float invA = 1.0f / a;
+  float tnear = (-b - s) * invA;
+  float hit = tnear < 0.0f ? (-b + s) * invA : tnear;
+  if (hit < maxT && !(hit < 0.0f)) {
+    t = hit;
+    return true;
+  }
+  return false;
+}
+
+// Moller-Trumbore
+bool intersectTriangle(const Ray &ray, const vec3 &a, const vec3 &b,
+                       const vec3 &c, float maxT, float &t, float &u,
+                       float &v) {
+  vec3 e1 = b - a;
+  vec3 e2 = c - a;
+  vec3 p = cross(ray.direction, e2);
+  float det = dotLanes(e1, p);
+  if (!(fabsf(det) > RAY_EPSILON)) {
+    return false;
+  }
+  float inv = 1.0f / det;
+  vec3 s = ray.origin - a;
+  float hu = dotLanes(s, p) * inv;
+  vec3 q = cross(s, e1);
+  float hv = dotLanes(ray.direction, q) * inv;
+  float ht = dotLanes(e2, q) * inv;
+  if (hu < 0.0f || hv < 0.0f || 1.0f < hu + hv ||
+      !(RAY_EPSILON < ht && ht < maxT)) {
+    return false;
+  }
+  t = ht;
+  u = hu;
+  v = hv;
+  return true;
+}
+
+static inline const vec3 &vertex(const vec3 *vertices,
+                                 const unsigned int *indices, unsigned int i,
+                                 int k) {
+  return vertices[indices ? indices[i * 3 + k] : i * 3 + k];
+}
+
+static inline TriangleX4 makeTriangleX4(const vec3X4 &a, const vec3X4 &b,
+                                        const vec3X4 &c) {
+  return {a, b - a, c - a};
+}
+
+// One ray against primitives gathered four at a time by load4(i); the last
+// count % 4 go through single(i, maxT, t, u, v).
+template <typename Load, typename Single>
+static RayHit intersectStream(const Ray &ray, unsigned int count, float maxT,
+                              const Load &load4, const Single &single) {
+  RayX4 r = makeRayX4(splat(ray.origin), splat(ray.direction));
+  NearestX4 best = {f4Splat(maxT), f4Splat(0.0f), f4Splat(0.0f), {}};
+  for (unsigned int &index : best.index) {
+    index = RAY_NO_HIT;
+  }
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    f4 t, u, v;
+    f4 hit = intersectX4(r, load4(i), best.t, t, u, v);
+    best.update(hit, i, 1, t, u, v);
+  }
+
+  // Nearest lane, the lowest index on a tie
+  float t[4], u[4], v[4];
+  f4Store(t, best.t);
+  f4Store(u, best.u);
+  f4Store(v, best.v);
+  RayHit result = {maxT, 0.0f, 0.0f, RAY_NO_HIT};
+  for (int lane = 0; lane < 4; ++lane) {
+    if (best.index[lane] != RAY_NO_HIT &&
+        (t[lane] < result.t ||
+         (t[lane] == result.t && best.index[lane] < result.index))) {
+      result = {t[lane], u[lane], v[lane], best.index[lane]};
+    }
+  }
+  for (; i < count; ++i) {
+    RayHit h = {0.0f, 0.0f, 0.0f, i};
+    if (single(i, result.t, h.t, h.u, h.v)) {
+      result = h;
+    }
+  }
+  return result;
+}
+
+RayHit intersectAabbs(const Ray &ray, const Aabb *boxes, unsigned int count,
+                      float maxT) {
+  return intersectStream(
+      ray, count, maxT,
+      [&](unsigned int i) {
+        const float *const p[4] = {boxes[i].min.v, boxes[i + 1].min.v,
+                                   boxes[i + 2].min.v, boxes[i + 3].min.v};
+        // Six floats per box, moved with two overlapping transposes
+        AabbX4 b;
+        f4 unused0, unused1;
+        loadTransposed(p, 0, b.min.x, b.min.y, b.min.z, b.max.x);
+        loadTransposed(p, 2, unused0, unused1, b.max.y, b.max.z);
+        return b;
+      },
+      [&](unsigned int i, float maxT, float &t, float &, float &) {
+        return intersectAabb(ray, boxes[i], maxT, t);
+      });
+}
+
+RayHit intersectSpheres(const Ray &ray, const Sphere *spheres,
+                        unsigned int count, float maxT) {
+  static_assert(sizeof(Sphere) == 4 * sizeof(float),
+                "Sphere is expected to be four packed floats");
+  return intersectStream(
+      ray, count, maxT,
+      [&](unsigned int i) {
+        const float *const p[4] = {spheres[i].center.v, spheres[i + 1].center.v,
+                                   spheres[i + 2].center.v,
+                                   spheres[i + 3].center.v};
+        SphereX4 s;
+        loadTransposed(p, 0, s.center.x, s.center.y, s.center.z, s.radius);
+        return s;
+      },
+      [&](unsigned int i, float maxT, float &t, float &, float &) {
+        return intersectSphere(ray, spheres[i], maxT, t);
+      });
+}
+
+RayHit intersectTriangles(const Ray &ray, const vec3 *vertices,
+                          const unsigned int *indices,
+                          unsigned int triangleCount, float maxT) {
+  return intersectStream(
+      ray, triangleCount, maxT,
+      [&](unsigned int i) {
+        vec3X4 corners[3];
+        for (int k = 0; k < 3; ++k) {
+          corners[k] = gather(vertex(vertices, indices, i, k),
+                              vertex(vertices, indices, i + 1, k),
+                              vertex(vertices, indices, i + 2, k),
+                              vertex(vertices, indices, i + 3, k));
+        }
+        return makeTriangleX4(corners[0], corners[1], corners[2]);
+      },
+      [&](unsigned int i, float maxT, float &t, float &u, float &v) {
+        return intersectTriangle(ray, vertex(vertices, indices, i, 0),
+                                 vertex(vertices, indices, i, 1),
+                                 vertex(vertices, indices, i, 2), maxT, t, u,
+                                 v);
+      });
+}
+
+RayPacket4 makeRayPacket4(const Ray *rays) {
+  RayPacket4 p;
+  for (int i = 0; i < 4; ++i) {
+    p.originX[i] = rays[i].origin.x;
+    p.originY[i] = rays[i].origin.y;
+    p.originZ[i] = rays[i].origin.z;
+    p.directionX[i] = rays[i].direction.x;
+    p.directionY[i] = rays[i].direction.y;
+    p.directionZ[i] = rays[i].direction.z;
+  }
+  return p;
+}
+
+RayPacket8 makeRayPacket8(const Ray *rays) {
+  RayPacket8 p;
+  for (int i = 0; i < 8; ++i) {
+    p.originX[i] = rays[i].origin.x;
+    p.originY[i] = rays[i].origin.y;
+    p.originZ[i] = rays[i].origin.z;
+    p.directionX[i] = rays[i].direction.x;
+    p.directionY[i] = rays[i].direction.y;
+    p.directionZ[i] = rays[i].direction.z;
+  }
+  return p;
+}
+
+void makeRayHits(float maxT, RayHits4 &hits) {
+  for (int i = 0; i < 4; ++i) {
+    hits.t[i] = maxT;
+    hits.u[i] = hits.v[i] = 0.0f;
+    hits.index[i] = RAY_NO_HIT;
+  }
+}
+
+void makeRayHits(float maxT, RayHits8 &hits) {
+  for (int i = 0; i < 8; ++i) {
+    hits.t[i] = maxT;
+    hits.u[i] = hits.v[i] = 0.0f;
+    hits.index[i] = RAY_NO_HIT;
+  }
+}
+
+RayHit getRayHit(const RayHits4 &hits, unsigned int ray) {
+  return {hits.t[ray], hits.u[ray], hits.v[ray], hits.index[ray]};
+}
+
+RayHit getRayHit(const RayHits8 &hits, unsigned int ray) {
+  return {hits.t[ray], hits.u[ray], hits.v[ray], hits.index[ray]};
+}
+
+// The packet is G groups of four rays. Every primitive is splatted once by
+// load(i) and tested against all groups.
+template <int G, typename Packet, typename Hits, typename Load>
+static void intersectPacket(const Packet &rays, Hits &hits, unsigned int count,
+                            const Load &load) {
+  RayX4 r[G];
+  NearestX4 best[G];
+  for (int g = 0; g < G; ++g) {
+    int o = g * 4;
+    r[g] = makeRayX4({f4Load(rays.originX + o), f4Load(rays.originY + o),
+                      f4Load(rays.originZ + o)},
+                     {f4Load(rays.directionX + o), f4Load(rays.directionY + o),
+                      f4Load(rays.directionZ + o)});
+    best[g] = {f4Load(hits.t + o), f4Load(hits.u + o), f4Load(hits.v + o),
+               {hits.index[o], hits.index[o + 1], hits.index[o + 2],
+                hits.index[o + 3]}};
+  }
+  for (unsigned int i = 0; i < count; ++i) {
+    auto primitive = load(i);
+    for (int g = 0; g < G; ++g) {
+      f4 t, u, v;
+      f4 hit = intersectX4(r[g], primitive, best[g].t, t, u, v);
+      best[g].update(hit, i, 0, t, u, v);
+    }
+  }
+  for (int g = 0; g < G; ++g) {
+    int o = g * 4;
+    f4Store(hits.t + o, best[g].t);
+    f4Store(hits.u + o, best[g].u);
+    f4Store(hits.v + o, best[g].v);
+    for (int lane = 0; lane < 4; ++lane) {
+      hits.index[o + lane] = best[g].index[lane];
+    }
+  }
+}
+
+static inline AabbX4 splat(const Aabb &b) {
+  return {splat(b.min), splat(b.max)};
+}
+
+static inline SphereX4 splat(const Sphere &s) {
+  return {splat(s.center), f4Splat(s.radius)};
+}
+
+static inline TriangleX4 splatTriangle(const vec3 *vertices,
+                                       const unsigned int *indices,
+                                       unsigned int i) {
+  const vec3 &a = vertex(vertices, indices, i, 0);
+  return {splat(a), splat(vertex(vertices, indices, i, 1) - a),
+          splat(vertex(vertices, indices, i, 2) - a)};
+}
+
+void intersectAabbs(const RayPacket4 &rays, const Aabb *boxes,
+                    unsigned int count, RayHits4 &hits) {
+  intersectPacket<1>(rays, hits, count,
+                     [&](unsigned int i) { return splat(boxes[i]); });
+}
+
+void intersectAabbs(const RayPacket8 &rays, const Aabb *boxes,
+                    unsigned int count, RayHits8 &hits) {
+  intersectPacket<2>(rays, hits, count,
+                     [&](unsigned int i) { return splat(boxes[i]); });
+}
+
+void intersectSpheres(const RayPacket4 &rays, const Sphere *spheres,
+                      unsigned int count, RayHits4 &hits) {
+  intersectPacket<1>(rays, hits, count,
+                     [&](unsigned int i) { return splat(spheres[i]); });
+}
+
+void intersectSpheres(const RayPacket8 &rays, const Sphere *spheres,
+                      unsigned int count, RayHits8 &hits) {
+  intersectPacket<2>(rays, hits, count,
+                     [&](unsigned int i) { return splat(spheres[i]); });
+}
+
+void intersectTriangles(const RayPacket4 &rays, const vec3 *vertices,
+                        const unsigned int *indices,
+                        unsigned int triangleCount, RayHits4 &hits) {
+  intersectPacket<1>(rays, hits, triangleCount, [&](unsigned int i) {
+    return splatTriangle(vertices, indices, i);
+  });
+}
+
+void intersectTriangles(const RayPacket8 &rays, const vec3 *vertices,
+                        const unsigned int *indices,
+                        unsigned int triangleCount, RayHits8 &hits) {
+  intersectPacket<2>(rays, hits, triangleCount, [&](unsigned int i) {
+    return splatTriangle(vertices, indices, i);
+  });
+}
@@ -0,0 +1,125 @@
+#pragma once
+// Lane versions of the ray tests in ray.cpp, shared with the BVH traversal.
+// The primitives or the rays may be the lanes; the other side is splatted.
+#include "ray.h"
+#include "transformSimd.h"
+
+// Four rays in lanes, or one ray splatted across them
+struct RayX4 {
+  vec3X4 origin;
+  vec3X4 direction;
+  vec3X4 inv;
+};
+
+struct AabbX4 {
+  vec3X4 min;
+  vec3X4 max;
+};
+
+struct SphereX4 {
+  vec3X4 center;
+  f4 radius;
+};
+
+struct TriangleX4 {
+  vec3X4 a;
+  vec3X4 e1;
+  vec3X4 e2;
+};
+
+// Nearest hit so far in every lane. index is written only on a hit, which
+// is rare enough that the lanes are walked in scalar code.
+struct NearestX4 {
+  f4 t, u, v;
+  unsigned int index[4];
+
+  void update(f4 hit, unsigned int base, unsigned int step, f4 ht, f4 hu,
+              f4 hv) {
+    int bits = f4MaskBits(hit);
+    if (!bits) {
+      return;
+    }
+    t = f4Select(hit, ht, t);
+    u = f4Select(hit, hu, u);
+    v = f4Select(hit, hv, v);
+    for (unsigned int lane = 0; lane < 4; ++lane) {
+      if (bits >> lane & 1) {
+        index[lane] = base + lane * step;
+      }
+    }
+  }
+};
+
+inline vec3X4 operator-(const vec3X4 &a, const vec3X4 &b) {
+  return {f4Sub(a.x, b.x), f4Sub(a.y, b.y), f4Sub(a.z, b.z)};
+}
+
+inline vec3X4 splat(const vec3 &v) {
+  return {f4Splat(v.x), f4Splat(v.y), f4Splat(v.z)};
+}
+
+inline vec3X4 gather(const vec3 &p0, const vec3 &p1, const vec3 &p2,
+                     const vec3 &p3) {
+  return {f4Set(p0.x, p1.x, p2.x, p3.x), f4Set(p0.y, p1.y, p2.y, p3.y),
+          f4Set(p0.z, p1.z, p2.z, p3.z)};
+}
+
+inline RayX4 makeRayX4(const vec3X4 &origin, const vec3X4 &direction) {
+  f4 one = f4Splat(1.0f);
+  return {origin, direction,
+          {f4Div(one, direction.x), f4Div(one, direction.y),
+           f4Div(one, direction.z)}};
+}
+
+inline f4 intersectX4(const RayX4 &r, const AabbX4 &b, f4 best, f4 &t, f4 &u,
+                      f4 &v) {
+  f4 x0 = f4Mul(f4Sub(b.min.x, r.origin.x), r.inv.x);
+  f4 x1 = f4Mul(f4Sub(b.max.x, r.origin.x), r.inv.x);
+  f4 y0 = f4Mul(f4Sub(b.min.y, r.origin.y), r.inv.y);
+  f4 y1 = f4Mul(f4Sub(b.max.y, r.origin.y), r.inv.y);
+  f4 z0 = f4Mul(f4Sub(b.min.z, r.origin.z), r.inv.z);
+  f4 z1 = f4Mul(f4Sub(b.max.z, r.origin.z), r.inv.z);
+  f4 tnear = f4Max(f4Max(f4Min(x0, x1), f4Min(y0, y1)), f4Min(z0, z1));
+  f4 tfar = f4Min(f4Min(f4Max(x0, x1), f4Max(y0, y1)), f4Max(z0, z1));
+  t = f4Max(tnear, f4Splat(0.0f));
+  u = v = f4Splat(0.0f);
+  return f4AndNot(f4Less(t, best), f4Less(tfar, t));
+}
+
+inline f4 intersectX4(const RayX4 &r, const SphereX4 &s, f4 best, f4 &t,
+                      f4 &u, f4 &v) {
+  f4 zero = f4Splat(0.0f);
+  vec3X4 oc = r.origin - s.center;
+  f4 a = dot(r.direction, r.direction);
+  f4 b = dot(oc, r.direction);
+  f4 c = f4Sub(dot(oc, oc), f4Mul(s.radius, s.radius));
+  f4 disc = f4Sub(f4Mul(b, b), f4Mul(a, c));
+  f4 root = f4Sqrt(f4Max(disc, zero));
+  f4 invA = f4Div(f4Splat(1.0f), a);
+  f4 nb = f4Sub(zero, b);
+  f4 tnear = f4Mul(f4Sub(nb, root), invA);
+  t = f4Select(f4Less(tnear, zero), f4Mul(f4Add(nb, root), invA), tnear);
+  u = v = zero;
+  return f4AndNot(f4AndNot(f4Less(t, best), f4Less(t, zero)),
+                  f4Less(disc, zero));
+}
+
+inline f4 intersectX4(const RayX4 &r, const TriangleX4 &tri, f4 best,
+                      f4 &t, f4 &u, f4 &v) {
+  f4 zero = f4Splat(0.0f);
+  f4 one = f4Splat(1.0f);
+  f4 eps = f4Splat(RAY_EPSILON);
+  vec3X4 p = cross(r.direction, tri.e2);
+  f4 det = dot(tri.e1, p);
+  f4 inv = f4Div(one, det);
+  vec3X4 s = r.origin - tri.a;
+  u = f4Mul(dot(s, p), inv);
+  vec3X4 q = cross(s, tri.e1);
+  v = f4Mul(dot(r.direction, q), inv);
+  t = f4Mul(dot(tri.e2, q), inv);
+  f4 inside = f4And(f4Less(eps, f4Max(det, f4Sub(zero, det))),
+                    f4And(f4Less(eps, t), f4Less(t, best)));
+  f4 outside =
+      f4Or(f4Less(u, zero), f4Or(f4Less(v, zero), f4Less(one, f4Add(u, v))));
+  return f4AndNot(inside, outside);
+}
@@ -0,0 +1,154 @@
+#include "sceneTransforms.h"
+#include <algorithm>
+
+static const unsigned char kDirty = 1;
+static const unsigned char kInverseValid = 2;
+static const unsigned char kMoved = 4;
+// The dirty subtrees are walked when they hold fewer than one node per this
+// many nodes the index order pass would scan
+static const unsigned int kWalkRatio = 64;
+
+// Nodes still to visit below a dirty node. Reused between calls on the same
+// thread.
+static thread_local std::vector<unsigned int> stackScratch;
+
+static void link(SceneTransforms &scene, unsigned int node) {
+  int p = scene.parents[node];
+  scene.nextSibling[node] = p < 0 ? -1 : scene.firstChild[p];
+  if (p >= 0) {
+    scene.firstChild[p] = (int)node;
+  }
+}
+
+void initSceneTransforms(SceneTransforms &scene, const Transform *local,
+                         const int *parents, unsigned int count) {
+  scene.local.assign(local, local + count);
+  scene.parents.assign(parents, parents + count);
+  scene.worldTransforms.resize(count);
+  scene.world.resize(count);
+  scene.inverseWorld.resize(count);
+  scene.firstChild.assign(count, -1);
+  scene.nextSibling.resize(count);
+  scene.subtreeSize.assign(count, 1);
+  scene.flags.assign(count, kDirty);
+  scene.dirty.resize(count);
+  scene.changed.clear();
+  // Backwards, so every child list ends up in ascending order
+  for (unsigned int i = count; i-- > 0;) {
+    link(scene, i);
+    scene.dirty[i] = i;
+    if (parents[i] >= 0) {
+      scene.subtreeSize[parents[i]] += scene.subtreeSize[i];
+    }
+  }
+}
+
+unsigned int addSceneNode(SceneTransforms &scene, int parent,
+                          const Transform &local) {
+  unsigned int node = (unsigned int)scene.local.size();
+  scene.local.push_back(local);
+  scene.parents.push_back(parent);
+  scene.worldTransforms.emplace_back();
+  scene.world.emplace_back();
+  scene.inverseWorld.emplace_back();
+  scene.firstChild.push_back(-1);
+  scene.nextSibling.push_back(-1);
+  scene.subtreeSize.push_back(1);
+  scene.flags.push_back(kDirty);
+  scene.dirty.push_back(node);
+  link(scene, node);
+  for (int p = parent; p >= 0; p = scene.parents[p]) {
+    ++scene.subtreeSize[p];
+  }
+  return node;
+}
+
+void setLocalTransform(SceneTransforms &scene, unsigned int node,
+                       const Transform &local) {
+  scene.local[node] = local;
+  if (!(scene.flags[node] & kDirty)) {
+    scene.flags[node] |= kDirty;
+    scene.dirty.push_back(node);
+  }
+}
+
+static void updateNode(SceneTransforms &scene, unsigned int i) {
+  int p = scene.parents[i];
+  scene.worldTransforms[i] =
+      p < 0 ? scene.local[i]
+            : combine(scene.worldTransforms[p], scene.local[i]);
+  scene.world[i] = transformToMat4(scene.worldTransforms[i]);
+  scene.changed.push_back(i);
+}
+
+// Walks the child lists below each dirty node. Parents come before their
+// children, so in ascending order every dirty ancestor is reached first; its
+// walk clears the dirty bits below it and those entries are skipped.
+static void updateSubtrees(SceneTransforms &scene) {
+  std::sort(scene.dirty.begin(), scene.dirty.end());
+  std::vector<unsigned int> &stack = stackScratch;
+  for (unsigned int root : scene.dirty) {
+    if (!(scene.flags[root] & kDirty)) {
+      continue;
+    }
+    stack.assign(1, root);
+    while (!stack.empty()) {
+      unsigned int i = stack.back();
+      stack.pop_back();
+      updateNode(scene, i);
+      scene.flags[i] = 0;
+      for (int c = scene.firstChild[i]; c >= 0; c = scene.nextSibling[c]) {
+        stack.push_back((unsigned int)c);
+      }
+    }
+  }
+}
+
+// One pass in index order from the first dirty node, which sees every
+// parent's kMoved before its children. Touches the nodes in memory order.
+static void updateRange(SceneTransforms &scene, unsigned int first) {
+  unsigned int count = (unsigned int)scene.local.size();
+  unsigned char *flags = scene.flags.data();
+  const int *parents = scene.parents.data();
+  for (unsigned int i = first; i < count; ++i) {
+    int p = parents[i];
+    if ((flags[i] & kDirty) || (p >= 0 && (flags[p] & kMoved))) {
+      updateNode(scene, i);
+      flags[i] = kMoved;
+    }
+  }
+  for (unsigned int i : scene.changed) {
+    flags[i] = 0;
+  }
+}
+
+// The walk pays a cache miss or two per node it visits, the pass a flag test
+// per node after the first dirty one. The dirty subtree sizes bound what the
+// walk visits (nested dirty nodes are counted twice), so the walk is only
+// taken when they are small next to the rest of the scene.
+void updateSceneTransforms(SceneTransforms &scene) {
+  scene.changed.clear();
+  if (scene.dirty.empty()) {
+    return;
+  }
+  unsigned int first = scene.dirty[0];
+  size_t visited = 0;
+  for (unsigned int i : scene.dirty) {
+    first = std::min(first, i);
+    visited += scene.subtreeSize[i];
+  }
+  if (visited * kWalkRatio < scene.local.size() - first) {
+    updateSubtrees(scene);
+  } else {
+    updateRange(scene, first);
+  }
+  scene.dirty.clear();
+}
+
+const mat4 &getInverseWorldMatrix(SceneTransforms &scene, unsigned int node) {
+  if (!(scene.flags[node] & kInverseValid)) {
+    scene.inverseWorld[node] = inverseAuto(scene.world[node]);
+    scene.flags[node] |= kInverseValid;
+  }
+  return scene.inverseWorld[node];
+}
@@ -0,0 +1,287 @@
+#pragma once
+// Internal 4-wide float abstraction used by the batch kernels. Picks SSE2 on
+// x86, NEON on ARM and falls back to plain scalar code everywhere else.
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATHS_SIMD_SSE
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define MATHS_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(MATHS_SIMD_SSE)
+typedef __m128 f4;
+
+inline f4 f4Load(const float *p) { return _mm_loadu_ps(p); }
+inline void f4Store(float *p, f4 a) { _mm_storeu_ps(p, a); }
+inline f4 f4Splat(float f) { return _mm_set1_ps(f); }
+// Lanes 0 to 3 from registers, without a round trip through memory
+inline f4 f4Set(float a, float b, float c, float d) {
+  return _mm_setr_ps(a, b, c, d);
+}
+inline f4 f4Add(f4 a, f4 b) { return _mm_add_ps(a, b); }
+inline f4 f4Sub(f4 a, f4 b) { return _mm_sub_ps(a, b); }
+inline f4 f4Mul(f4 a, f4 b) { return _mm_mul_ps(a, b); }
+inline f4 f4MulAdd(f4 a, f4 b, f4 c) {
+  return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+inline f4 f4Min(f4 a, f4 b) { return _mm_min_ps(a, b); }
+inline f4 f4Max(f4 a, f4 b) { return _mm_max_ps(a, b); }
+inline f4 f4Div(f4 a, f4 b) { return _mm_div_ps(a, b); }
+inline f4 f4Sqrt(f4 a) { return _mm_sqrt_ps(a); }
+inline float f4First(f4 a) { return _mm_cvtss_f32(a); }
+// a with its sign flipped in the lanes where s is negative
+inline f4 f4MulSign(f4 a, f4 s) {
+  return _mm_xor_ps(a, _mm_and_ps(s, _mm_set1_ps(-0.0f)));
+}
+
+// (a1, a0, a3, a2) and (a2, a3, a0, a1)
+inline f4 f4SwapPairs(f4 a) {
+  return _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+}
+inline f4 f4SwapHalves(f4 a) {
+  return _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2));
+}
+
+// Lane masks: f4Less sets the lanes where a < b, f4MaskBits packs one bit
+// per lane (lane 0 in bit 0).
+inline f4 f4Less(f4 a, f4 b) { return _mm_cmplt_ps(a, b); }
+inline f4 f4Or(f4 a, f4 b) { return _mm_or_ps(a, b); }
+inline f4 f4And(f4 a, f4 b) { return _mm_and_ps(a, b); }
+// a and not b
+inline f4 f4AndNot(f4 a, f4 b) { return _mm_andnot_ps(b, a); }
+inline int f4MaskBits(f4 mask) { return _mm_movemask_ps(mask); }
+// a in the lanes set in mask, b elsewhere
+inline f4 f4Select(f4 mask, f4 a, f4 b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+// Converts to 32-bit integers, rounding to nearest.
+inline void f4StoreInt(int *p, f4 a) {
+  _mm_storeu_si128((__m128i *)p, _mm_cvtps_epi32(a));
+}
+// Non-temporal store to a 16-byte aligned address. Call f4StreamFence()
+// before anything else reads the stored data.
+inline void f4Stream(float *p, f4 a) { _mm_stream_ps(p, a); }
+inline void f4StreamFence() { _mm_sfence(); }
+
+inline void f4Transpose(f4 &a, f4 &b, f4 &c, f4 &d) {
+  _MM_TRANSPOSE4_PS(a, b, c, d);
+}
+
+#define F4_SHUFFLE(a, b, i0, i1, i2, i3)                                       \
+  _mm_shuffle_ps(a, b, _MM_SHUFFLE(i3, i2, i1, i0))
+
+// Deinterleaves four packed vec3s (12 floats) into x, y and z lanes.
+inline void f4Load3(const float *p, f4 &x, f4 &y, f4 &z) {
+  f4 a = _mm_loadu_ps(p);     // x0 y0 z0 x1
+  f4 b = _mm_loadu_ps(p + 4); // y1 z1 x2 y2
+  f4 c = _mm_loadu_ps(p + 8); // z2 x3 y3 z3
+  x = F4_SHUFFLE(a, F4_SHUFFLE(b, c, 2, 2, 1, 1), 0, 3, 0, 2);
+  y = F4_SHUFFLE(F4_SHUFFLE(a, b, 1, 1, 0, 0), F4_SHUFFLE(b, c, 3, 3, 2, 2), 0,
+                 2, 0, 2);
+  z = F4_SHUFFLE(F4_SHUFFLE(a, b, 2, 2, 1, 1), F4_SHUFFLE(c, c, 0, 0, 3, 3), 0,
+                 2, 0, 2);
+}
+
+// Interleaves x, y and z lanes back into four packed vec3s.
+inline void f4Store3(float *p, f4 x, f4 y, f4 z) {
+  _mm_storeu_ps(p, F4_SHUFFLE(F4_SHUFFLE(x, y, 0, 0, 0, 0),
+                              F4_SHUFFLE(z, x, 0, 0, 1, 1), 0, 2, 0, 2));
+  _mm_storeu_ps(p + 4, F4_SHUFFLE(F4_SHUFFLE(y, z, 1, 1, 1, 1),
+                                  F4_SHUFFLE(x, y, 2, 2, 2, 2), 0, 2, 0, 2));
+  _mm_storeu_ps(p + 8, F4_SHUFFLE(F4_SHUFFLE(z, x, 2, 2, 3, 3),
+                                  F4_SHUFFLE(y, z, 3, 3, 3, 3), 0, 2, 0, 2));
+}
+
+#undef F4_SHUFFLE
+
+#elif defined(MATHS_SIMD_NEON)
+typedef float32x4_t f4;
+
+inline f4 f4Load(const float *p) { return vld1q_f32(p); }
+inline void f4Store(float *p, f4 a) { vst1q_f32(p, a); }
+inline f4 f4Splat(float f) { return vdupq_n_f32(f); }
+inline f4 f4Set(float a, float b, float c, float d) {
+  float32x4_t r = vdupq_n_f32(a);
+  r = vsetq_lane_f32(b, r, 1);
+  r = vsetq_lane_f32(c, r, 2);
+  return vsetq_lane_f32(d, r, 3);
+}
+inline f4 f4Add(f4 a, f4 b) { return vaddq_f32(a, b); }
+inline f4 f4Sub(f4 a, f4 b) { return vsubq_f32(a, b); }
+inline f4 f4Mul(f4 a, f4 b) { return vmulq_f32(a, b); }
+inline f4 f4MulAdd(f4 a, f4 b, f4 c) { return vmlaq_f32(c, a, b); }
+inline f4 f4Min(f4 a, f4 b) { return vminq_f32(a, b); }
+inline f4 f4Max(f4 a, f4 b) { return vmaxq_f32(a, b); }
+#if defined(__aarch64__) || defined(_M_ARM64)
+inline f4 f4Div(f4 a, f4 b) { return vdivq_f32(a, b); }
+inline f4 f4Sqrt(f4 a) { return vsqrtq_f32(a); }
+#else
+inline f4 f4Div(f4 a, f4 b) {
+  f4 r = vrecpeq_f32(b);
+  r = vmulq_f32(r, vrecpsq_f32(b, r));
+  r = vmulq_f32(r, vrecpsq_f32(b, r));
+  return vmulq_f32(a, r);
+}
+inline f4 f4Sqrt(f4 a) {
+  f4 r = vrsqrteq_f32(a);
+  r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a, r), r));
+  r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a, r), r));
+  return vmulq_f32(a, r);
+}
+#endif
+inline float f4First(f4 a) { return vgetq_lane_f32(a, 0); }
+inline f4 f4MulSign(f4 a, f4 s) {
+  uint32x4_t sign =
+      vandq_u32(vreinterpretq_u32_f32(s), vdupq_n_u32(0x80000000u));
+  return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a), sign));
+}
+inline f4 f4SwapPairs(f4 a) { return vrev64q_f32(a); }
+inline f4 f4SwapHalves(f4 a) { return vextq_f32(a, a, 2); }
+
+inline f4 f4Less(f4 a, f4 b) { return vreinterpretq_f32_u32(vcltq_f32(a, b)); }
+inline f4 f4Or(f4 a, f4 b) {
+  return vreinterpretq_f32_u32(
+      vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+inline f4 f4And(f4 a, f4 b) {
+  return vreinterpretq_f32_u32(
+      vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+inline f4 f4AndNot(f4 a, f4 b) {
+  return vreinterpretq_f32_u32(
+      vbicq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+inline int f4MaskBits(f4 mask) {
+  uint32x4_t m = vshrq_n_u32(vreinterpretq_u32_f32(mask), 31);
+  return (int)(vgetq_lane_u32(m, 0) | vgetq_lane_u32(m, 1) << 1 |
+               vgetq_lane_u32(m, 2) << 2 | vgetq_lane_u32(m, 3) << 3);
+}
+inline f4 f4Select(f4 mask, f4 a, f4 b) {
+  return vbslq_f32(vreinterpretq_u32_f32(mask), a, b);
+}
+#if defined(__aarch64__) || defined(_M_ARM64)
+inline void f4StoreInt(int *p, f4 a) { vst1q_s32(p, vcvtnq_s32_f32(a)); }
+#else
+inline void f4StoreInt(int *p, f4 a) {
+  f4 half = f4MulSign(vdupq_n_f32(0.5f), a);
+  vst1q_s32(p, vcvtq_s32_f32(vaddq_f32(a, half)));
+}
+#endif
+// NEON has no non-temporal store intrinsic; these are plain stores.
+inline void f4Stream(float *p, f4 a) { vst1q_f32(p, a); }
+inline void f4StreamFence() {}
+
+inline void f4Transpose(f4 &a, f4 &b, f4 &c, f4 &d) {
+  float32x4x2_t ab = vtrnq_f32(a, b);
+  float32x4x2_t cd = vtrnq_f32(c, d);
+  a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+  b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+  c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+  d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+}
+
+inline void f4Load3(const float *p, f4 &x, f4 &y, f4 &z) {
+  float32x4x3_t v = vld3q_f32(p);
+  x = v.val[0];
+  y = v.val[1];
+  z = v.val[2];
+}
+
+inline void f4Store3(float *p, f4 x, f4 y, f4 z) {
+  float32x4x3_t v;
+  v.val[0] = x;
+  v.val[1] = y;
+  v.val[2] = z;
+  vst3q_f32(p, v);
+}
+
+#else
+#define MATHS_SIMD_SCALAR
+#include <math.h>
+
+struct f4 {
+  float v[4];
+};
+
+#define F4_OP(expr)                                                            \
+  f4 r;                                                                        \
+  for (int i = 0; i < 4; ++i) {                                                \
+    r.v[i] = expr;                                                             \
+  }                                                                            \
+  return r;
+
+inline f4 f4Load(const float *p) { F4_OP(p[i]) }
+inline void f4Store(float *p, f4 a) {
+  for (int i = 0; i < 4; ++i) {
+    p[i] = a.v[i];
+  }
+}
+inline f4 f4Splat(float f) { F4_OP(f) }
+inline f4 f4Set(float a, float b, float c, float d) { return {{a, b, c, d}}; }
+inline f4 f4Add(f4 a, f4 b) { F4_OP(a.v[i] + b.v[i]) }
+inline f4 f4Sub(f4 a, f4 b) { F4_OP(a.v[i] - b.v[i]) }
+inline f4 f4Mul(f4 a, f4 b) { F4_OP(a.v[i] * b.v[i]) }
+inline f4 f4MulAdd(f4 a, f4 b, f4 c) { F4_OP(a.v[i] * b.v[i] + c.v[i]) }
+inline f4 f4Min(f4 a, f4 b) { F4_OP(a.v[i] < b.v[i] ? a.v[i] : b.v[i]) }
+inline f4 f4Max(f4 a, f4 b) { F4_OP(a.v[i] > b.v[i] ? a.v[i] : b.v[i]) }
+inline f4 f4Div(f4 a, f4 b) { F4_OP(a.v[i] / b.v[i]) }
+inline f4 f4Sqrt(f4 a) { F4_OP(sqrtf(a.v[i])) }
+inline float f4First(f4 a) { return a.v[0]; }
+inline f4 f4MulSign(f4 a, f4 s) { F4_OP(s.v[i] < 0.0f ? -a.v[i] : a.v[i]) }
+inline f4 f4SwapPairs(f4 a) { F4_OP(a.v[i ^ 1]) }
+inline f4 f4SwapHalves(f4 a) { F4_OP(a.v[i ^ 2]) }
+// Mask lanes are 1 or 0 here; they are only combined with f4Or, f4And and
+// f4AndNot and read by f4MaskBits and f4Select.
+inline f4 f4Less(f4 a, f4 b) { F4_OP(a.v[i] < b.v[i] ? 1.0f : 0.0f) }
+inline f4 f4Or(f4 a, f4 b) { F4_OP(a.v[i] != 0.0f || b.v[i] != 0.0f) }
+inline f4 f4And(f4 a, f4 b) { F4_OP(a.v[i] != 0.0f && b.v[i] != 0.0f) }
+inline f4 f4AndNot(f4 a, f4 b) { F4_OP(a.v[i] != 0.0f && b.v[i] == 0.0f) }
+inline int f4MaskBits(f4 mask) {
+  int bits = 0;
+  for (int i = 0; i < 4; ++i) {
+    bits |= (mask.v[i] != 0.0f) << i;
+  }
+  return bits;
+}
+inline f4 f4Select(f4 mask, f4 a, f4 b) {
+  F4_OP(mask.v[i] != 0.0f ? a.v[i] : b.v[i])
+}
+inline void f4StoreInt(int *p, f4 a) {
+  for (int i = 0; i < 4; ++i) {
+    p[i] = (int)lrintf(a.v[i]);
+  }
+}
+inline void f4Stream(float *p, f4 a) { f4Store(p, a); }
+inline void f4StreamFence() {}
+
+inline void f4Transpose(f4 &a, f4 &b, f4 &c, f4 &d) {
+  f4 r[4] = {a, b, c, d};
+  for (int i = 0; i < 4; ++i) {
+    a.v[i] = r[i].v[0];
+    b.v[i] = r[i].v[1];
+    c.v[i] = r[i].v[2];
+    d.v[i] = r[i].v[3];
+  }
+}
+
+inline void f4Load3(const float *p, f4 &x, f4 &y, f4 &z) {
+  for (int i = 0; i < 4; ++i) {
+    x.v[i] = p[i * 3 + 0];
+    y.v[i] = p[i * 3 + 1];
+    z.v[i] = p[i * 3 + 2];
+  }
+}
+
+inline void f4Store3(float *p, f4 x, f4 y, f4 z) {
+  for (int i = 0; i < 4; ++i) {
+    p[i * 3 + 0] = x.v[i];
+    p[i * 3 + 1] = y.v[i];
+    p[i * 3 + 2] = z.v[i];
+  }
+}
+
+#undef F4_OP
+#endif
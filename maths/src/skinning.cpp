@@ -0,0 +1,225 @@
+#include "skinning.h"
+#include "parallel.h"
+#include "transformSimd.h"
+#include <stdint.h>
+
+static inline void loadDualQuatX4(const DualQuaternion *palette,
+                                  const ivec4 *joints, int influence,
+                                  quatX4 &real, quatX4 &dual) {
+  const float *const p[4] = {palette[joints[0].v[influence]].v,
+                             palette[joints[1].v[influence]].v,
+                             palette[joints[2].v[influence]].v,
+                             palette[joints[3].v[influence]].v};
+  loadTransposed(p, 0, real.x, real.y, real.z, real.w);
+  loadTransposed(p, 4, dual.x, dual.y, dual.z, dual.w);
+}
+
+static inline DualQuaternion blendOne(const DualQuaternion *palette,
+                                      const ivec4 &joints,
+                                      const vec4 &weights) {
+  const DualQuaternion &first = palette[joints.x];
+  DualQuaternion result = first * weights.x;
+  for (int i = 1; i < 4; ++i) {
+    const DualQuaternion &dq = palette[joints.v[i]];
+    float w = dot(dq.parts.real, first.parts.real) < 0.0f ? -weights.v[i]
+                                                           : weights.v[i];
+    result = result + dq * w;
+  }
+  return normalized(result);
+}
+
+static void skinRange(const DualQuaternion *palette, const ivec4 *joints,
+                      const vec4 *weights, const vec3 *positions,
+                      const vec3 *normals, vec3 *outPositions,
+                      vec3 *outNormals, unsigned int begin, unsigned int end) {
+  bool skinNormals = normals && outNormals;
+  f4 two = f4Splat(2.0f);
+  unsigned int i = begin;
+  for (; i + 4 <= end; i += 4) {
+    const float *const w[4] = {weights[i].v, weights[i + 1].v,
+                               weights[i + 2].v, weights[i + 3].v};
+    f4 w0, w1, w2, w3;
+    loadTransposed(w, 0, w0, w1, w2, w3);
+
+    quatX4 r0, d0, r, d;
+    loadDualQuatX4(palette, joints + i, 0, r0, d0);
+    quatX4 real = r0 * w0;
+    quatX4 dual = d0 * w0;
+    f4 wi[3] = {w1, w2, w3};
+    for (int k = 0; k < 3; ++k) {
+      loadDualQuatX4(palette, joints + i, k + 1, r, d);
+      f4 s = f4MulSign(wi[k], dot(r, r0));
+      real = real + r * s;
+      dual = dual + d * s;
+    }
+
+    normalizeDualQuatX4(real, dual);
+
+    // Same translation as transformPoint(const DualQuaternion &, const vec3 &)
+    quatX4 conj = {f4Sub(f4Splat(0.0f), real.x), f4Sub(f4Splat(0.0f), real.y),
+                   f4Sub(f4Splat(0.0f), real.z), real.w};
+    quatX4 t = conj * (dual * two);
+
+    vec3X4 p;
+    f4Load3(positions[i].v, p.x, p.y, p.z);
+    p = real * p + vec3X4{t.x, t.y, t.z};
+    f4Store3(outPositions[i].v, p.x, p.y, p.z);
+    if (skinNormals) {
+      vec3X4 n;
+      f4Load3(normals[i].v, n.x, n.y, n.z);
+      n = real * n;
+      f4Store3(outNormals[i].v, n.x, n.y, n.z);
+    }
+  }
+  for (; i < end; ++i) {
+    DualQuaternion dq = blendOne(palette, joints[i], weights[i]);
+    outPositions[i] = transformPoint(dq, positions[i]);
+    if (skinNormals) {
+      outNormals[i] = transformVector(dq, normals[i]);
+    }
+  }
+}
+
+void skinDualQuaternion(const DualQuaternion *palette, const ivec4 *joints,
+                        const vec4 *weights, const vec3 *positions,
+                        const vec3 *normals, vec3 *outPositions,
+                        vec3 *outNormals, unsigned int vertexCount) {
+  skinRange(palette, joints, weights, positions, normals, outPositions,
+            outNormals, 0, vertexCount);
+}
+
+void skinDualQuaternionParallel(const DualQuaternion *palette,
+                                const ivec4 *joints, const vec4 *weights,
+                                const vec3 *positions, const vec3 *normals,
+                                vec3 *outPositions, vec3 *outNormals,
+                                unsigned int vertexCount) {
+  parallelFor(vertexCount, 4096, [&](unsigned int begin, unsigned int end) {
+    skinRange(palette, joints, weights, positions, normals, outPositions,
+              outNormals, begin, end);
+  });
+}
+
+// Palettes at least this large are streamed past the cache: 192 KB of 3x4
+// matrices, more than a core's share of L2 on most targets.
+static const unsigned int kStreamJoints = 4096;
+
+static bool usesStreaming(const void *out, unsigned int jointCount) {
+  return jointCount >= kStreamJoints && ((uintptr_t)out & 15) == 0;
+}
+
+static inline void storeRow(float *p, f4 a, bool stream) {
+  if (stream) {
+    f4Stream(p, a);
+  } else {
+    f4Store(p, a);
+  }
+}
+
+// Multiplies four pairs of matrices held in lanes, both as cols[c][r], and
+// writes the top three rows of each product to twelve floats per joint.
+static inline void storePalette3x4(const f4 w[4][4], const f4 b[4][4],
+                                   float *out, bool stream) {
+  f4 rows[3][4];
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 4; ++c) {
+      rows[r][c] = f4MulAdd(
+          w[0][r], b[c][0],
+          f4MulAdd(w[1][r], b[c][1],
+                   f4MulAdd(w[2][r], b[c][2], f4Mul(w[3][r], b[c][3]))));
+    }
+  }
+  for (int r = 0; r < 3; ++r) {
+    f4 a = rows[r][0], b1 = rows[r][1], c = rows[r][2], d = rows[r][3];
+    f4Transpose(a, b1, c, d);
+    storeRow(out + r * 4, a, stream);
+    storeRow(out + 12 + r * 4, b1, stream);
+    storeRow(out + 24 + r * 4, c, stream);
+    storeRow(out + 36 + r * 4, d, stream);
+  }
+}
+
+static inline void storePalette3x4(const mat4 &m, float *out) {
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 4; ++c) {
+      out[r * 4 + c] = m.v[c * 4 + r];
+    }
+  }
+}
+
+void buildSkinningPalette(const Transform *world, const mat4 *inverseBindPose,
+                          float *out, unsigned int jointCount) {
+  bool stream = usesStreaming(out, jointCount);
+  unsigned int i = 0;
+  for (; i + 4 <= jointCount; i += 4) {
+    f4 w[4][4], b[4][4];
+    transformToMat4X4(loadTransformX4(world + i, world + i + 1, world + i + 2,
+                                      world + i + 3),
+                      w);
+    loadMat4X4(inverseBindPose + i, inverseBindPose + i + 1,
+               inverseBindPose + i + 2, inverseBindPose + i + 3, b);
+    storePalette3x4(w, b, out + i * 12, stream);
+  }
+  for (; i < jointCount; ++i) {
+    storePalette3x4(transformToMat4(world[i]) * inverseBindPose[i],
+                    out + i * 12);
+  }
+  if (stream) {
+    f4StreamFence();
+  }
+}
+
+void buildSkinningPalette(const mat4 *world, const mat4 *inverseBindPose,
+                          float *out, unsigned int jointCount) {
+  bool stream = usesStreaming(out, jointCount);
+  unsigned int i = 0;
+  for (; i + 4 <= jointCount; i += 4) {
+    f4 w[4][4], b[4][4];
+    loadMat4X4(world + i, world + i + 1, world + i + 2, world + i + 3, w);
+    loadMat4X4(inverseBindPose + i, inverseBindPose + i + 1,
+               inverseBindPose + i + 2, inverseBindPose + i + 3, b);
+    storePalette3x4(w, b, out + i * 12, stream);
+  }
+  for (; i < jointCount; ++i) {
+    storePalette3x4(world[i] * inverseBindPose[i], out + i * 12);
+  }
+  if (stream) {
+    f4StreamFence();
+  }
+}
+
+void buildSkinningPalette(const Transform *world,
+                          const Transform *inverseBindPose,
+                          DualQuaternion *out, unsigned int jointCount) {
+  bool stream = usesStreaming(out, jointCount);
+  f4 half = f4Splat(0.5f);
+  unsigned int i = 0;
+  for (; i + 4 <= jointCount; i += 4) {
+    const Transform *b = inverseBindPose + i;
+    TransformX4 t = combine(
+        loadTransformX4(world + i, world + i + 1, world + i + 2, world + i + 3),
+        loadTransformX4(b, b + 1, b + 2, b + 3));
+    // Same as transformToDualQuat(): dual = real * (position, 0) * 0.5
+    quatX4 d = {t.position.x, t.position.y, t.position.z, f4Splat(0.0f)};
+    quatX4 real = t.rotation;
+    quatX4 dual = (real * d) * half;
+    f4 r0 = real.x, r1 = real.y, r2 = real.z, r3 = real.w;
+    f4 d0 = dual.x, d1 = dual.y, d2 = dual.z, d3 = dual.w;
+    f4Transpose(r0, r1, r2, r3);
+    f4Transpose(d0, d1, d2, d3);
+    float *p = out[i].v;
+    storeRow(p, r0, stream);
+    storeRow(p + 4, d0, stream);
+    storeRow(p + 8, r1, stream);
+    storeRow(p + 12, d1, stream);
+    storeRow(p + 16, r2, stream);
+    storeRow(p + 20, d2, stream);
+    storeRow(p + 24, r3, stream);
+    storeRow(p + 28, d3, stream);
+  }
+  for (; i < jointCount; ++i) {
+    out[i] = transformToDualQuat(combine(world[i], inverseBindPose[i]));
+  }
+  if (stream) {
+    f4StreamFence();
+  }
+}
@@ -0,0 +1,169 @@
+#include "textFormat.h"
+#include <charconv>
+#include <string.h>
+#if !defined(__cpp_lib_to_chars)
+#include <stdio.h>
+#include <stdlib.h>
+#endif
+
+// Standard libraries without floating point to_chars fall back to printf
+// with 9 significant digits, which also reads back exactly but is slower
+// and follows the C locale's decimal point.
+static char *writeFloat(char *out, float f) {
+#if defined(__cpp_lib_to_chars)
+  return std::to_chars(out, out + TEXT_FLOAT_MAX_CHARS, f).ptr;
+#else
+  return out + snprintf(out, TEXT_FLOAT_MAX_CHARS, "%.9g", (double)f);
+#endif
+}
+
+static bool isSpace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+static const char *readFloat(const char *p, const char *end, float &f) {
+#if defined(__cpp_lib_to_chars)
+  std::from_chars_result r = std::from_chars(p, end, f);
+  return r.ec == std::errc() ? r.ptr : nullptr;
+#else
+  // strtof wants a terminated string
+  char token[64];
+  size_t n = 0;
+  while (p + n < end && !isSpace(p[n]) && n < sizeof(token) - 1) {
+    token[n] = p[n];
+    ++n;
+  }
+  token[n] = '\0';
+  char *stop;
+  f = strtof(token, &stop);
+  return stop == token ? nullptr : p + (stop - token);
+#endif
+}
+
+static void toFloats(const vec3 &v, float *f) {
+  f[0] = v.x;
+  f[1] = v.y;
+  f[2] = v.z;
+}
+
+static void toFloats(const quat &q, float *f) {
+  f[0] = q.x;
+  f[1] = q.y;
+  f[2] = q.z;
+  f[3] = q.w;
+}
+
+static void toFloats(const mat4 &m, float *f) { memcpy(f, m.v, sizeof(m.v)); }
+
+static void toFloats(const Transform &t, float *f) {
+  toFloats(t.position, f);
+  toFloats(t.rotation, f + 3);
+  toFloats(t.scale, f + 7);
+}
+
+static void fromFloats(const float *f, vec3 &v) { v = vec3(f[0], f[1], f[2]); }
+
+static void fromFloats(const float *f, quat &q) {
+  q = quat(f[0], f[1], f[2], f[3]);
+}
+
+static void fromFloats(const float *f, mat4 &m) { memcpy(m.v, f, sizeof(m.v)); }
+
+static void fromFloats(const float *f, Transform &t) {
+  fromFloats(f, t.position);
+  fromFloats(f + 3, t.rotation);
+  fromFloats(f + 7, t.scale);
+}
+
+template <unsigned int N> static char *writeLine(char *out, const float *f) {
+  for (unsigned int i = 0; i < N; ++i) {
+    out = writeFloat(out, f[i]);
+    *out++ = i + 1 < N ? ' ' : '\n';
+  }
+  return out;
+}
+
+// Lines are written straight into out while the worst case still fits, and
+// through a scratch line near the end of the buffer.
+template <unsigned int N, typename T>
+static size_t format(const T *in, char *out, size_t capacity,
+                     unsigned int count) {
+  const size_t worst = N * TEXT_FLOAT_MAX_CHARS;
+  char *p = out;
+  char *end = out + capacity;
+  float f[N];
+  for (unsigned int i = 0; i < count; ++i) {
+    toFloats(in[i], f);
+    if ((size_t)(end - p) >= worst) {
+      p = writeLine<N>(p, f);
+      continue;
+    }
+    char line[worst];
+    size_t n = (size_t)(writeLine<N>(line, f) - line);
+    if (n > (size_t)(end - p)) {
+      return 0;
+    }
+    memcpy(p, line, n);
+    p += n;
+  }
+  return (size_t)(p - out);
+}
+
+template <unsigned int N, typename T>
+static unsigned int parse(const char *text, size_t length, T *out,
+                          unsigned int count) {
+  const char *p = text;
+  const char *end = text + length;
+  float f[N];
+  for (unsigned int i = 0; i < count; ++i) {
+    for (unsigned int j = 0; j < N; ++j) {
+      while (p < end && isSpace(*p)) {
+        ++p;
+      }
+      p = p < end ? readFloat(p, end, f[j]) : nullptr;
+      if (!p) {
+        return i;
+      }
+    }
+    fromFloats(f, out[i]);
+  }
+  return count;
+}
+
+size_t formatText(const vec3 *in, char *out, size_t capacity,
+                  unsigned int count) {
+  return format<3>(in, out, capacity, count);
+}
+
+size_t formatText(const quat *in, char *out, size_t capacity,
+                  unsigned int count) {
+  return format<4>(in, out, capacity, count);
+}
+
+size_t formatText(const mat4 *in, char *out, size_t capacity,
+                  unsigned int count) {
+  return format<16>(in, out, capacity, count);
+}
+
+size_t formatText(const Transform *in, char *out, size_t capacity,
+                  unsigned int count) {
+  return format<10>(in, out, capacity, count);
+}
+
+unsigned int parseText(const char *text, size_t length, vec3 *out,
+                       unsigned int count) {
+  return parse<3>(text, length, out, count);
+}
+
+unsigned int parseText(const char *text, size_t length, quat *out,
+                       unsigned int count) {
+  return parse<4>(text, length, out, count);
+}
+
+unsigned int parseText(const char *text, size_t length, mat4 *out,
+                       unsigned int count) {
+  return parse<16>(text, length, out, count);
+}
+
+unsigned int parseText(const char *text, size_t length, Transform *out,
+                       unsigned int count) {
+  return parse<10>(text, length, out, count);
+}
@@ -0,0 +1,40 @@
+#include "parallel.h"
+#include "transform.h"
+#include "transformSimd.h"
+
+void inverse(const Transform *in, Transform *out, unsigned int count) {
+  for (unsigned int i = 0; i < count; ++i) {
+    out[i] = inverse(in[i]);
+  }
+}
+
+void inverseRigid(const Transform *in, Transform *out, unsigned int count) {
+  for (unsigned int i = 0; i < count; ++i) {
+    out[i] = inverseRigid(in[i]);
+  }
+}
+
+void transformToMat4(const Transform *in, mat4 *out, unsigned int count) {
+  unsigned int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    TransformX4 t = loadTransformX4(in + i, in + i + 1, in + i + 2, in + i + 3);
+    storeMat4X4(t, out + i, out + i + 1, out + i + 2, out + i + 3);
+  }
+  for (; i < count; ++i) {
+    out[i] = transformToMat4(in[i]);
+  }
+}
+
+void transformToMat4Parallel(const Transform *in, mat4 *out,
+                             unsigned int count, unsigned int grain) {
+  parallelFor(count, grain ? grain : 2048,
+              [&](unsigned int begin, unsigned int end) {
+                transformToMat4(in + begin, out + begin, end - begin);
+              });
+}
+
+void toTransform(const mat4 *in, Transform *out, unsigned int count) {
+  for (unsigned int i = 0; i < count; ++i) {
+    out[i] = toTransform(in[i]);
+  }
+}
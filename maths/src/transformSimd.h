@@ -0,0 +1,221 @@
+#pragma once
+// Four Transforms held component-wise in SIMD lanes, with the lane versions
+// of combine() and transformToMat4(). Dual quaternions are handled as pairs
+// of quatX4.
+#include "simd.h"
+#include "dualQuaternion.h"
+
+static_assert(sizeof(Transform) == 10 * sizeof(float),
+              "Transform is expected to be ten packed floats");
+static_assert(sizeof(DualQuaternion) == 8 * sizeof(float),
+              "DualQuaternion is expected to be eight packed floats");
+
+struct quatX4 {
+  f4 x, y, z, w;
+};
+
+struct vec3X4 {
+  f4 x, y, z;
+};
+
+struct TransformX4 {
+  vec3X4 position;
+  quatX4 rotation;
+  vec3X4 scale;
+};
+
+inline vec3X4 operator+(const vec3X4 &a, const vec3X4 &b) {
+  return {f4Add(a.x, b.x), f4Add(a.y, b.y), f4Add(a.z, b.z)};
+}
+
+inline vec3X4 operator*(const vec3X4 &a, const vec3X4 &b) {
+  return {f4Mul(a.x, b.x), f4Mul(a.y, b.y), f4Mul(a.z, b.z)};
+}
+
+inline vec3X4 operator*(const vec3X4 &a, f4 f) {
+  return {f4Mul(a.x, f), f4Mul(a.y, f), f4Mul(a.z, f)};
+}
+
+inline f4 dot(const vec3X4 &a, const vec3X4 &b) {
+  return f4MulAdd(a.x, b.x, f4MulAdd(a.y, b.y, f4Mul(a.z, b.z)));
+}
+
+inline vec3X4 cross(const vec3X4 &a, const vec3X4 &b) {
+  return {f4Sub(f4Mul(a.y, b.z), f4Mul(a.z, b.y)),
+          f4Sub(f4Mul(a.z, b.x), f4Mul(a.x, b.z)),
+          f4Sub(f4Mul(a.x, b.y), f4Mul(a.y, b.x))};
+}
+
+// Same operand order and formula as operator*(const quat &, const quat &)
+inline quatX4 operator*(const quatX4 &Q1, const quatX4 &Q2) {
+  quatX4 r;
+  r.x = f4Add(
+      f4Sub(f4MulAdd(Q2.x, Q1.w, f4Mul(Q2.y, Q1.z)), f4Mul(Q2.z, Q1.y)),
+      f4Mul(Q2.w, Q1.x));
+  r.y = f4Add(
+      f4Sub(f4MulAdd(Q2.y, Q1.w, f4Mul(Q2.z, Q1.x)), f4Mul(Q2.x, Q1.z)),
+      f4Mul(Q2.w, Q1.y));
+  r.z = f4Add(
+      f4Sub(f4MulAdd(Q2.x, Q1.y, f4Mul(Q2.z, Q1.w)), f4Mul(Q2.y, Q1.x)),
+      f4Mul(Q2.w, Q1.z));
+  r.w = f4Sub(f4Sub(f4Sub(f4Mul(Q2.w, Q1.w), f4Mul(Q2.x, Q1.x)),
+                    f4Mul(Q2.y, Q1.y)),
+              f4Mul(Q2.z, Q1.z));
+  return r;
+}
+
+// Same formula as operator*(const quat &, const vec3 &)
+inline vec3X4 operator*(const quatX4 &q, const vec3X4 &v) {
+  vec3X4 u = {q.x, q.y, q.z};
+  f4 two = f4Splat(2.0f);
+  f4 k = f4Sub(f4Mul(q.w, q.w), dot(u, u));
+  return u * f4Mul(two, dot(u, v)) + v * k + cross(u, v) * f4Mul(two, q.w);
+}
+
+inline quatX4 operator+(const quatX4 &a, const quatX4 &b) {
+  return {f4Add(a.x, b.x), f4Add(a.y, b.y), f4Add(a.z, b.z), f4Add(a.w, b.w)};
+}
+
+inline quatX4 operator*(const quatX4 &a, f4 f) {
+  return {f4Mul(a.x, f), f4Mul(a.y, f), f4Mul(a.z, f), f4Mul(a.w, f)};
+}
+
+inline f4 dot(const quatX4 &a, const quatX4 &b) {
+  return f4MulAdd(a.x, b.x,
+                  f4MulAdd(a.y, b.y, f4MulAdd(a.z, b.z, f4Mul(a.w, b.w))));
+}
+
+// Lane version of normalized(const DualQuaternion &): a real part shorter
+// than the epsilon gives the identity instead of being scaled.
+inline void normalizeDualQuatX4(quatX4 &real, quatX4 &dual) {
+  f4 zero = f4Splat(0.0f), one = f4Splat(1.0f);
+  f4 epsilon = f4Splat(DUALQUAT_EPSILON);
+  f4 lenSq = dot(real, real);
+  f4 degenerate = f4Less(lenSq, epsilon);
+  f4 invLen = f4Div(one, f4Sqrt(f4Max(lenSq, epsilon)));
+  real = real * invLen;
+  dual = dual * invLen;
+  real.x = f4Select(degenerate, zero, real.x);
+  real.y = f4Select(degenerate, zero, real.y);
+  real.z = f4Select(degenerate, zero, real.z);
+  real.w = f4Select(degenerate, one, real.w);
+  dual.x = f4Select(degenerate, zero, dual.x);
+  dual.y = f4Select(degenerate, zero, dual.y);
+  dual.z = f4Select(degenerate, zero, dual.z);
+  dual.w = f4Select(degenerate, zero, dual.w);
+}
+
+inline TransformX4 combine(const TransformX4 &a, const TransformX4 &b) {
+  TransformX4 out;
+  out.scale = a.scale * b.scale;
+  out.rotation = b.rotation * a.rotation;
+  out.position = a.position + a.rotation * (a.scale * b.position);
+  return out;
+}
+
+// Loads four floats at offset from each pointer and transposes them, so a
+// holds element offset of every lane, b element offset + 1 and so on.
+inline void loadTransposed(const float *const p[4], int offset, f4 &a, f4 &b,
+                           f4 &c, f4 &d) {
+  a = f4Load(p[0] + offset);
+  b = f4Load(p[1] + offset);
+  c = f4Load(p[2] + offset);
+  d = f4Load(p[3] + offset);
+  f4Transpose(a, b, c, d);
+}
+
+inline void storeTransposed(float *const p[4], int offset, f4 a, f4 b, f4 c,
+                            f4 d) {
+  f4Transpose(a, b, c, d);
+  f4Store(p[0] + offset, a);
+  f4Store(p[1] + offset, b);
+  f4Store(p[2] + offset, c);
+  f4Store(p[3] + offset, d);
+}
+
+inline quatX4 loadQuatX4(const quat *q) {
+  quatX4 r;
+  const float *const p[4] = {q[0].v, q[1].v, q[2].v, q[3].v};
+  loadTransposed(p, 0, r.x, r.y, r.z, r.w);
+  return r;
+}
+
+inline void storeQuatX4(const quatX4 &q, quat *out) {
+  float *const p[4] = {out[0].v, out[1].v, out[2].v, out[3].v};
+  storeTransposed(p, 0, q.x, q.y, q.z, q.w);
+}
+
+// Gathers four Transforms into lanes. The ten floats are moved with three
+// overlapping 4x4 transposes: [0, 4), [4, 8) and [6, 10).
+inline TransformX4 loadTransformX4(const Transform *t0, const Transform *t1,
+                                   const Transform *t2, const Transform *t3) {
+  const float *const p[4] = {(const float *)t0, (const float *)t1,
+                             (const float *)t2, (const float *)t3};
+  TransformX4 r;
+  // The transpose must not alias its outputs, so each skipped row gets its
+  // own variable.
+  f4 unused0, unused1;
+  loadTransposed(p, 0, r.position.x, r.position.y, r.position.z,
+                 r.rotation.x);
+  loadTransposed(p, 4, r.rotation.y, r.rotation.z, r.rotation.w, r.scale.x);
+  loadTransposed(p, 6, unused0, unused1, r.scale.y, r.scale.z);
+  return r;
+}
+
+inline void storeTransformX4(const TransformX4 &t, Transform *t0,
+                             Transform *t1, Transform *t2, Transform *t3) {
+  float *const p[4] = {(float *)t0, (float *)t1, (float *)t2, (float *)t3};
+  storeTransposed(p, 0, t.position.x, t.position.y, t.position.z,
+                  t.rotation.x);
+  storeTransposed(p, 4, t.rotation.y, t.rotation.z, t.rotation.w, t.scale.x);
+  storeTransposed(p, 6, t.rotation.w, t.scale.x, t.scale.y, t.scale.z);
+}
+
+// Lane version of transformToMat4(), with the same expansion as quatToMat4().
+// cols[c][r] holds row r of column c.
+inline void transformToMat4X4(const TransformX4 &t, f4 cols[4][4]) {
+  const quatX4 &q = t.rotation;
+  f4 two = f4Splat(2.0f);
+  f4 k = f4Sub(f4Mul(q.w, q.w),
+               f4MulAdd(q.x, q.x, f4MulAdd(q.y, q.y, f4Mul(q.z, q.z))));
+  f4 x2 = f4Mul(q.x, two), y2 = f4Mul(q.y, two), z2 = f4Mul(q.z, two);
+  f4 xx = f4Mul(q.x, x2), yy = f4Mul(q.y, y2), zz = f4Mul(q.z, z2);
+  f4 xy = f4Mul(q.x, y2), xz = f4Mul(q.x, z2), yz = f4Mul(q.y, z2);
+  f4 wx = f4Mul(q.w, x2), wy = f4Mul(q.w, y2), wz = f4Mul(q.w, z2);
+
+  f4 zero = f4Splat(0.0f);
+  cols[0][0] = f4Mul(f4Add(xx, k), t.scale.x);
+  cols[0][1] = f4Mul(f4Add(xy, wz), t.scale.x);
+  cols[0][2] = f4Mul(f4Sub(xz, wy), t.scale.x);
+  cols[0][3] = zero;
+  cols[1][0] = f4Mul(f4Sub(xy, wz), t.scale.y);
+  cols[1][1] = f4Mul(f4Add(yy, k), t.scale.y);
+  cols[1][2] = f4Mul(f4Add(yz, wx), t.scale.y);
+  cols[1][3] = zero;
+  cols[2][0] = f4Mul(f4Add(xz, wy), t.scale.z);
+  cols[2][1] = f4Mul(f4Sub(yz, wx), t.scale.z);
+  cols[2][2] = f4Mul(f4Add(zz, k), t.scale.z);
+  cols[2][3] = zero;
+  cols[3][0] = t.position.x;
+  cols[3][1] = t.position.y;
+  cols[3][2] = t.position.z;
+  cols[3][3] = f4Splat(1.0f);
+}
+
+inline void loadMat4X4(const mat4 *m0, const mat4 *m1, const mat4 *m2,
+                       const mat4 *m3, f4 cols[4][4]) {
+  const float *const p[4] = {m0->v, m1->v, m2->v, m3->v};
+  for (int c = 0; c < 4; ++c) {
+    loadTransposed(p, c * 4, cols[c][0], cols[c][1], cols[c][2], cols[c][3]);
+  }
+}
+
+inline void storeMat4X4(const TransformX4 &t, mat4 *m0, mat4 *m1, mat4 *m2,
+                        mat4 *m3) {
+  f4 cols[4][4];
+  transformToMat4X4(t, cols);
+  float *const p[4] = {m0->v, m1->v, m2->v, m3->v};
+  for (int c = 0; c < 4; ++c) {
+    storeTransposed(p, c * 4, cols[c][0], cols[c][1], cols[c][2], cols[c][3]);
+  }
+}